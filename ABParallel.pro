@@ -26,4 +26,5 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += main.cpp
 
 HEADERS += \
-    include\parallel.h
+    include\parallel.h \
+    include\parallel_io.h
@@ -7,8 +7,30 @@
 /// Licence:     Attribution-NonCommercial 4.0 International
 /////////////////////////////////////////////////////////////////////////////
 
+#ifndef ABPARALLEL_H
+#define ABPARALLEL_H
+
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <future>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ABPARALLEL_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace ABParallel {
 
@@ -148,6 +170,262 @@ auto par_sum(srcIt first, srcIt last, functor func, size_t chunkSize) -> typenam
     return acc1+acc2;
 }
 
+// Parallel version of std::adjacent_difference
+// The element preceding each chunk is read before any task starts, so the destination may be the source
+
+template <typename srcIt, typename dstIt, typename functor>
+auto par_adjacent_difference(srcIt first, srcIt last, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= chunkSize) {
+        return std::adjacent_difference(first, last, dst, func);
+    }
+    auto previousValues = std::vector<valueType>{};
+    previousValues.reserve(n / chunkSize + 1);
+    for (size_t startId = chunkSize; startId < n; startId += chunkSize)
+        previousValues.push_back(*(first + (startId - 1)));
+
+    // Create a table of futures to handle each chunk asynchronously
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(n / chunkSize + 1);
+    futures.emplace_back(std::async(std::launch::async, [=, &func] {
+        std::adjacent_difference(first, first + chunkSize, dst, func);
+    }));
+    for (size_t startId = chunkSize, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &func, &previousValues] {
+            valueType previous = previousValues[chunkId];
+            auto chunkDst = std::next(dst, startId);
+            for (auto it = first + startId; it != first + stopId; it = std::next(it), chunkDst = std::next(chunkDst)) {
+                valueType value = *it;
+                *chunkDst = func(value, previous);
+                previous = std::move(value);
+            }
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    return std::next(dst, n);
+}
+
+template <typename srcIt, typename dstIt>
+auto par_adjacent_difference(srcIt first, srcIt last, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_adjacent_difference(first, last, dst, std::minus<valueType>(), chunkSize);
+}
+
+namespace detail {
+
+// Multiply-add used by the leaves of par_inner_product: fused multiply-adds are used for the floating point
+// types for which the hardware provides them (std::fma may otherwise fall back to a slow software routine)
+
+inline auto par_multiply_add(float a, float b, float c) -> float {
+#ifdef FP_FAST_FMAF
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
+inline auto par_multiply_add(double a, double b, double c) -> double {
+#ifdef FP_FAST_FMA
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
+inline auto par_multiply_add(long double a, long double b, long double c) -> long double {
+#ifdef FP_FAST_FMAL
+    return std::fma(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
+template <typename valueType>
+auto par_multiply_add(const valueType& a, const valueType& b, const valueType& c) -> valueType {
+    return a * b + c;
+}
+
+// Sequential dot product used by the leaves of par_inner_product. When both ranges hold elements of the type
+// of init, four independent accumulators break the dependency chain of the additions; otherwise the products
+// are computed in the types of the elements and added to init as std::inner_product does
+
+template <typename srcIt1, typename srcIt2, typename valueType>
+auto par_dot_product(srcIt1 first1, srcIt1 last1, srcIt2 first2, valueType init, std::true_type) -> valueType {
+    const auto n = static_cast<size_t>(std::distance(first1, last1));
+    valueType sum0(0), sum1(0), sum2(0), sum3(0);
+    auto i = size_t{0};
+    for (; i + 4 <= n; i += 4) {
+        sum0 = par_multiply_add(*(first1 + i), *(first2 + i), sum0);
+        sum1 = par_multiply_add(*(first1 + (i + 1)), *(first2 + (i + 1)), sum1);
+        sum2 = par_multiply_add(*(first1 + (i + 2)), *(first2 + (i + 2)), sum2);
+        sum3 = par_multiply_add(*(first1 + (i + 3)), *(first2 + (i + 3)), sum3);
+    }
+    for (; i < n; ++i)
+        sum0 = par_multiply_add(*(first1 + i), *(first2 + i), sum0);
+    return init + ((sum0 + sum1) + (sum2 + sum3));
+}
+
+template <typename srcIt1, typename srcIt2, typename valueType>
+auto par_dot_product(srcIt1 first1, srcIt1 last1, srcIt2 first2, valueType init, std::false_type) -> valueType {
+    return std::inner_product(first1, last1, first2, init);
+}
+
+template <typename srcIt1, typename srcIt2, typename valueType>
+auto par_dot_product(srcIt1 first1, srcIt1 last1, srcIt2 first2, valueType init) -> valueType {
+    using sameTypes = std::integral_constant<bool,
+        std::is_same<typename std::iterator_traits<srcIt1>::value_type, valueType>::value &&
+        std::is_same<typename std::iterator_traits<srcIt2>::value_type, valueType>::value>;
+    return par_dot_product(first1, last1, first2, init, sameTypes());
+}
+
+} // namespace detail
+
+// Parallel version of std::inner_product
+
+template <typename srcIt1, typename srcIt2, typename valueType>
+auto par_inner_product(srcIt1 first1, srcIt1 last1, srcIt2 first2, valueType init, size_t chunkSize) -> valueType {
+    const auto n = static_cast<size_t>(std::distance(first1, last1));
+    if (n <= chunkSize) {
+        return detail::par_dot_product(first1, last1, first2, init);
+    }
+    const auto srcMiddle = std::next(first1, n / 2);
+
+    // Create a new task to treat the first part
+    auto future = std::async(std::launch::async, [=] () -> valueType {
+        return par_inner_product(first1, srcMiddle, first2, init, chunkSize);
+    });
+
+    // Treat the second part recursively
+    const auto srcMiddle2 = std::next(first2, n / 2);
+    auto acc1 = par_inner_product(srcMiddle, last1, srcMiddle2, static_cast<valueType>(0), chunkSize);
+
+    // Collect the sum of both parts
+    auto acc2 = future.get();
+    return acc2 + acc1;
+}
+
+// Generalized parallel version of std::inner_product: reduces with func1 the results of func2 applied to each
+// pair of elements. func1 must be associative
+
+template <typename srcIt1, typename srcIt2, typename valueType, typename functor1, typename functor2>
+auto par_inner_product(srcIt1 first1, srcIt1 last1, srcIt2 first2, valueType init, functor1 func1, functor2 func2, size_t chunkSize) -> valueType {
+    const auto n = static_cast<size_t>(std::distance(first1, last1));
+    if (n <= chunkSize) {
+        return std::inner_product(first1, last1, first2, init, func1, func2);
+    }
+    const auto srcMiddle = std::next(first1, n / 2);
+
+    // Create a new task to treat the first part
+    auto future = std::async(std::launch::async, [=, &func1, &func2] () -> valueType {
+        return par_inner_product(first1, srcMiddle, first2, init, func1, func2, chunkSize);
+    });
+
+    // Treat the second part recursively, seeding it with its first pair since func1 may have no neutral element
+    const auto srcMiddle2 = std::next(first2, n / 2);
+    valueType seed = func2(*srcMiddle, *srcMiddle2);
+    auto acc1 = par_inner_product(std::next(srcMiddle), last1, std::next(srcMiddle2), seed, func1, func2, chunkSize);
+
+    // Collect the result of both parts
+    auto acc2 = future.get();
+    return func1(acc2, acc1);
+}
+
+namespace detail {
+
+// Whether a value type is a single byte integer (char, signed char, unsigned char, std::uint8_t...) for which
+// table-driven or SIMD kernels can be used
+
+template <typename valueType>
+struct par_is_byte_type : std::integral_constant<bool,
+    std::is_integral<valueType>::value && !std::is_same<valueType, bool>::value && sizeof(valueType) == 1> {};
+
+// Whether an iterator points to contiguous storage: pointers and the iterators of std::vector and std::string
+
+template <typename srcIt>
+struct par_is_contiguous_iterator : std::integral_constant<bool,
+    std::is_pointer<srcIt>::value ||
+    std::is_same<srcIt, typename std::vector<typename std::iterator_traits<srcIt>::value_type>::iterator>::value ||
+    std::is_same<srcIt, typename std::vector<typename std::iterator_traits<srcIt>::value_type>::const_iterator>::value ||
+    std::is_same<srcIt, std::string::iterator>::value ||
+    std::is_same<srcIt, std::string::const_iterator>::value> {};
+
+// Whether the byte kernels below can be used on a range
+
+template <typename srcIt>
+struct par_is_byte_range : std::integral_constant<bool,
+    par_is_byte_type<typename std::iterator_traits<srcIt>::value_type>::value && par_is_contiguous_iterator<srcIt>::value> {};
+
+// Count the occurrences of a byte in a buffer. With SSE2, 16 bytes are compared at once and the matches are
+// accumulated in 8-bit lanes, which are summed every 255 iterations before they can overflow
+
+inline auto par_count_bytes(const unsigned char* data, size_t n, unsigned char byte) -> size_t {
+    auto count = size_t{0};
+    auto i = size_t{0};
+#ifdef ABPARALLEL_SSE2
+    const auto needle = _mm_set1_epi8(static_cast<char>(byte));
+    while (i + 16 <= n) {
+        auto matches = _mm_setzero_si128();
+        const auto blockStop = i + 16 * std::min((n - i) / 16, size_t{255});
+        for (; i < blockStop; i += 16) {
+            const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            matches = _mm_sub_epi8(matches, _mm_cmpeq_epi8(bytes, needle));
+        }
+        const auto sums = _mm_sad_epu8(matches, _mm_setzero_si128());
+        count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_extract_epi16(sums, 4));
+    }
+#endif
+    for (; i < n; ++i)
+        count += data[i] == byte ? 1 : 0;
+    return count;
+}
+
+// Sequential count used by the leaves of par_count
+
+template <typename srcIt, typename valueType>
+auto par_count_leaf(srcIt first, srcIt last, const valueType& value, std::false_type) -> typename std::iterator_traits<srcIt>::difference_type {
+    return std::count(first, last, value);
+}
+
+template <typename srcIt, typename valueType>
+auto par_count_leaf(srcIt first, srcIt last, const valueType& value, std::true_type) -> typename std::iterator_traits<srcIt>::difference_type {
+    using byteType = typename std::iterator_traits<srcIt>::value_type;
+    using counterType = typename std::iterator_traits<srcIt>::difference_type;
+    const auto byte = static_cast<byteType>(value);
+    if (first == last || !(byte == value)) {
+        return 0;
+    }
+    const auto data = reinterpret_cast<const unsigned char*>(&*first);
+    return static_cast<counterType>(par_count_bytes(data, static_cast<size_t>(std::distance(first, last)), static_cast<unsigned char>(byte)));
+}
+
+// Sequential find used by the leaves of par_find
+
+template <typename srcIt, typename valueType>
+auto par_find_leaf(srcIt first, srcIt last, const valueType& value, std::false_type) -> srcIt {
+    return std::find(first, last, value);
+}
+
+template <typename srcIt, typename valueType>
+auto par_find_leaf(srcIt first, srcIt last, const valueType& value, std::true_type) -> srcIt {
+    using byteType = typename std::iterator_traits<srcIt>::value_type;
+    const auto byte = static_cast<byteType>(value);
+    if (first == last || !(byte == value)) {
+        return last;
+    }
+
+    // memchr is vectorized by the C library
+    const auto data = reinterpret_cast<const unsigned char*>(&*first);
+    const auto found = std::memchr(data, static_cast<unsigned char>(byte), static_cast<size_t>(std::distance(first, last)));
+    return found == nullptr ? last : std::next(first, static_cast<const unsigned char*>(found) - data);
+}
+
+} // namespace detail
+
 // Parallel version of std::count
 
 template <typename srcIt, typename valueType>
@@ -155,7 +433,7 @@ auto par_count(srcIt first, srcIt last, const valueType& value, size_t chunkSize
     using counterType=typename std::iterator_traits<srcIt>::difference_type;
     const auto n = static_cast<size_t>(std::distance(first, last));
     if (n <= chunkSize) {
-        return std::count(first, last, value);
+        return detail::par_count_leaf(first, last, value, detail::par_is_byte_range<srcIt>());
     }
     const auto srcMiddle = std::next(first, n / 2);
 
@@ -196,6 +474,200 @@ auto par_count_if(srcIt first, srcIt last, functor func, size_t chunkSize) -> ty
     return count1+count2;
 }
 
+// Parallel algorithm that counts the lines of a text buffer: the newline characters, plus one if the last
+// line is not terminated
+
+template <typename srcIt>
+auto par_count_lines(srcIt first, srcIt last, size_t chunkSize) -> typename std::iterator_traits<srcIt>::difference_type {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    if (first == last) {
+        return 0;
+    }
+    const auto newline = static_cast<valueType>('\n');
+    const auto count = par_count(first, last, newline, chunkSize);
+    return *std::prev(last) == newline ? count : count + 1;
+}
+
+namespace detail {
+
+// Find the boundaries of the records (lines) of a text buffer: returns the offset of the first character of
+// each record followed by the size of the buffer, so that record i spans [offsets[i], offsets[i + 1]) with
+// its terminating newline. When quoted is set, newlines between two quote characters belong to the record
+// (CSV quoted fields, escaped quotes being doubled). Each chunk first counts its quotes so that every task
+// knows whether it starts inside a quoted field, then the chunks collect their record starts independently
+
+template <typename srcIt>
+auto par_split_records(srcIt first, srcIt last, bool quoted, typename std::iterator_traits<srcIt>::value_type quote, size_t chunkSize) -> std::vector<size_t> {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto newline = static_cast<valueType>('\n');
+
+    // Count the quotes of each chunk asynchronously
+    auto quoteFutures = std::vector<std::future<size_t>>{};
+    quoteFutures.reserve(n / chunkSize + 1);
+    for (size_t startId = 0; startId < n && quoted; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=] () -> size_t {
+            return static_cast<size_t>(par_count_leaf(first + startId, first + stopId, quote, par_is_byte_range<srcIt>()));
+        });
+        quoteFutures.emplace_back(std::move(future));
+    }
+    auto quoteCounts = std::vector<size_t>{0};
+    for (auto& future : quoteFutures)
+        quoteCounts.push_back(quoteCounts.back() + future.get());
+
+    // Create a table of futures to collect the record starts of each chunk asynchronously
+    auto futures = std::vector<std::future<std::vector<size_t>>>{};
+    futures.reserve(n / chunkSize + 1);
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        const auto inQuotes = quoted && quoteCounts[chunkId] % 2 == 1;
+        auto future = std::async(std::launch::async, [=] () -> std::vector<size_t> {
+            auto starts = std::vector<size_t>{};
+            const auto chunkLast = first + stopId;
+            if (!quoted) {
+                for (auto it = par_find_leaf(first + startId, chunkLast, newline, par_is_byte_range<srcIt>()); it != chunkLast;
+                     it = par_find_leaf(std::next(it), chunkLast, newline, par_is_byte_range<srcIt>())) {
+                    starts.push_back(static_cast<size_t>(std::distance(first, it)) + 1);
+                }
+            }
+            else {
+                auto insideQuotes = inQuotes;
+                for (auto i = startId; i < stopId; ++i) {
+                    const valueType character = *(first + i);
+                    if (character == quote)
+                        insideQuotes = !insideQuotes;
+                    else if (character == newline && !insideQuotes)
+                        starts.push_back(i + 1);
+                }
+            }
+            if (!starts.empty() && starts.back() == n)
+                starts.pop_back();
+            return starts;
+        });
+        futures.emplace_back(std::move(future));
+    }
+    auto chunkStarts = std::vector<std::vector<size_t>>{};
+    chunkStarts.reserve(futures.size());
+    auto startOffsets = std::vector<size_t>{1};
+    for (auto& future : futures) {
+        chunkStarts.push_back(future.get());
+        startOffsets.push_back(startOffsets.back() + chunkStarts.back().size());
+    }
+
+    // Concatenate the record starts of all the chunks
+    auto offsets = std::vector<size_t>(startOffsets.back() + (n > 0 ? 1 : 0));
+    offsets.front() = 0;
+    offsets.back() = n;
+    auto copyFutures = std::vector<std::future<void>>{};
+    copyFutures.reserve(chunkStarts.size());
+    for (size_t chunkId = 0; chunkId < chunkStarts.size(); ++chunkId) {
+        auto future = std::async(std::launch::async, [=, &chunkStarts, &offsets] {
+            std::copy(chunkStarts[chunkId].begin(), chunkStarts[chunkId].end(), offsets.begin() + startOffsets[chunkId]);
+        });
+        copyFutures.emplace_back(std::move(future));
+    }
+    for (auto& future : copyFutures)
+        future.wait();
+
+    return offsets;
+}
+
+} // namespace detail
+
+// Parallel split of a text buffer into lines (see detail::par_split_records)
+
+template <typename srcIt>
+auto par_split_lines(srcIt first, srcIt last, size_t chunkSize) -> std::vector<size_t> {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return detail::par_split_records(first, last, false, valueType(), chunkSize);
+}
+
+// Parallel split of a CSV buffer into records, ignoring the newlines inside quoted fields
+// (see detail::par_split_records)
+
+template <typename srcIt>
+auto par_split_lines(srcIt first, srcIt last, typename std::iterator_traits<srcIt>::value_type quote, size_t chunkSize) -> std::vector<size_t> {
+    return detail::par_split_records(first, last, true, quote, chunkSize);
+}
+
+// Parallel histogram: counts the elements falling in each of the nbins bins given by func and writes the
+// counts to dst. Elements for which func returns a bin index greater or equal to nbins are ignored
+// Each chunk fills a private histogram and the private histograms are then reduced bin range by bin range.
+// The private histograms start on a cache line boundary and are padded to a whole number of cache lines, so
+// that no two chunks share a cache line. Each reduction task sums about chunkSize counters: a range of
+// chunkSize / nchunks bins, rounded up to whole cache lines
+
+template <typename srcIt, typename dstIt, typename functor>
+auto par_histogram(srcIt first, srcIt last, functor func, size_t nbins, dstIt dst, size_t chunkSize) -> dstIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto cacheLineSize = size_t{64};
+    const auto cacheLineCounters = cacheLineSize / sizeof(size_t);
+    const auto stride = (nbins + cacheLineCounters - 1) / cacheLineCounters * cacheLineCounters;
+    const auto nchunks = std::max(size_t{1}, (n + chunkSize - 1) / chunkSize);
+
+    // Over-allocate by a cache line and start the histograms at the first cache line boundary of the storage
+    auto storage = std::vector<size_t>(nchunks * stride + cacheLineCounters, 0);
+    const auto misalignment = static_cast<size_t>(reinterpret_cast<std::uintptr_t>(storage.data()) % cacheLineSize);
+    const auto histograms = storage.begin() + (misalignment == 0 ? 0 : (cacheLineSize - misalignment) / sizeof(size_t));
+
+    // Create a table of futures to fill the histogram of each chunk asynchronously
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(nchunks);
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto histogram = histograms + chunkId * stride;
+        auto future = std::async(std::launch::async, [=, &func] {
+            for (auto it = first + startId; it != first + stopId; it = std::next(it)) {
+                const auto bin = static_cast<size_t>(func(*it));
+                if (bin < nbins)
+                    ++histogram[bin];
+            }
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    // Reduce the private histograms, each task handling a range of bins
+    using counterType = typename std::iterator_traits<dstIt>::value_type;
+    const auto binsPerTask = (std::max(size_t{1}, chunkSize / nchunks) + cacheLineCounters - 1) / cacheLineCounters * cacheLineCounters;
+    auto reduceFutures = std::vector<std::future<void>>{};
+    reduceFutures.reserve(nbins / binsPerTask + 1);
+    for (size_t startBin = 0; startBin < nbins; startBin += binsPerTask) {
+        const auto stopBin = std::min(startBin + binsPerTask, nbins);
+        auto future = std::async(std::launch::async, [=] {
+            for (auto bin = startBin; bin < stopBin; ++bin) {
+                auto count = size_t{0};
+                for (size_t chunkId = 0; chunkId < nchunks; ++chunkId)
+                    count += histograms[chunkId * stride + bin];
+                *std::next(dst, bin) = static_cast<counterType>(count);
+            }
+        });
+        reduceFutures.emplace_back(std::move(future));
+    }
+    for (auto& future : reduceFutures)
+        future.wait();
+
+    return std::next(dst, nbins);
+}
+
+// Parallel histogram of numeric values with nbins bins of equal width spanning [lower, upper]. The upper
+// bound falls in the last bin and the values outside of the interval are ignored
+
+template <typename srcIt, typename dstIt, typename valueType>
+auto par_histogram(srcIt first, srcIt last, const valueType& lower, const valueType& upper, size_t nbins, dstIt dst, size_t chunkSize) -> dstIt {
+    const auto low = static_cast<double>(lower);
+    const auto high = static_cast<double>(upper);
+    const auto scale = high > low ? static_cast<double>(nbins) / (high - low) : 0.0;
+    return par_histogram(first, last, [=](const typename std::iterator_traits<srcIt>::value_type& a) -> size_t {
+        const auto value = static_cast<double>(a);
+        if (!(value >= low && value <= high))
+            return nbins;
+        return std::min(static_cast<size_t>((value - low) * scale), nbins - 1);
+    }, nbins, dst, chunkSize);
+}
+
 // Parallel version of std::copy
 
 template <typename srcIt, typename dstIt>
@@ -218,6 +690,79 @@ auto par_copy(srcIt first, srcIt last, dstIt dst, size_t chunkSize) -> void {
     future.wait();
 }
 
+namespace detail {
+
+// Hint the processor to fetch the cache line holding an address that will soon be accessed
+
+inline auto par_prefetch(const void* address) -> void {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+// Distance (in elements) at which the random accesses of gather and scatter are prefetched
+
+const size_t par_prefetch_distance = 16;
+
+} // namespace detail
+
+// Parallel gather: dst[i] = src[indices[i]] for each index
+
+template <typename indexIt, typename srcIt, typename dstIt>
+auto par_gather(indexIt indicesFirst, indexIt indicesLast, srcIt src, dstIt dst, size_t chunkSize) -> void {
+    const auto n = static_cast<size_t>(std::distance(indicesFirst, indicesLast));
+    if (n <= chunkSize) {
+        for (size_t i = 0; i < n; ++i) {
+            if (i + detail::par_prefetch_distance < n)
+                detail::par_prefetch(&*(src + *(indicesFirst + (i + detail::par_prefetch_distance))));
+            *(dst + i) = *(src + *(indicesFirst + i));
+        }
+        return;
+    }
+    const auto indicesMiddle = std::next(indicesFirst, n / 2);
+
+    // Create a new task to treat the first part
+    auto future = std::async(std::launch::async, [=] {
+        par_gather(indicesFirst, indicesMiddle, src, dst, chunkSize);
+    });
+
+    // Treat the second part recursively
+    const auto dstMiddle = std::next(dst, n / 2);
+    par_gather(indicesMiddle, indicesLast, src, dstMiddle, chunkSize);
+    future.wait();
+}
+
+// Parallel scatter: dst[indices[i]] = src[i] for each element of the source
+// Caution: the indices must be distinct, otherwise several tasks may write to the same element
+
+template <typename srcIt, typename indexIt, typename dstIt>
+auto par_scatter(srcIt first, srcIt last, indexIt indicesFirst, dstIt dst, size_t chunkSize) -> void {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= chunkSize) {
+        for (size_t i = 0; i < n; ++i) {
+            if (i + detail::par_prefetch_distance < n)
+                detail::par_prefetch(&*(dst + *(indicesFirst + (i + detail::par_prefetch_distance))));
+            *(dst + *(indicesFirst + i)) = *(first + i);
+        }
+        return;
+    }
+    const auto srcMiddle = std::next(first, n / 2);
+
+    // Create a new task to treat the first part
+    auto future = std::async(std::launch::async, [=] {
+        par_scatter(first, srcMiddle, indicesFirst, dst, chunkSize);
+    });
+
+    // Treat the second part recursively
+    const auto indicesMiddle = std::next(indicesFirst, n / 2);
+    par_scatter(srcMiddle, last, indicesMiddle, dst, chunkSize);
+    future.wait();
+}
+
 // Parallel version of std::copy_if
 
 template <typename srcIt, typename dstIt, typename functor>
@@ -255,7 +800,7 @@ template <typename srcIt, typename valueType>
 auto par_find(srcIt first, srcIt last, const valueType& value, size_t chunkSize) -> srcIt {
     const auto n = static_cast<size_t>(std::distance(first, last));
     if (n <= chunkSize) {
-        return std::find(first, last, value);
+        return detail::par_find_leaf(first, last, value, detail::par_is_byte_range<srcIt>());
     }
     const auto srcMiddle = std::next(first, n / 2);
 
@@ -404,176 +949,2041 @@ auto par_remove_if(srcIt first, srcIt last, functor func, size_t chunkSize) -> s
     return dstLast;
 }
 
-// Parallel version of std::sort
+namespace detail {
 
-// Perform a merge of two sorted containers
-template <typename srcIt, typename functor>
-auto par_merge(srcIt first, srcIt middle, srcIt last,functor func) -> void {
+// Flag the elements kept by std::unique, i.e. those differing from their predecessor, and return the
+// offsets of the kept elements of each chunk. The first element of a chunk is compared with the last
+// element of the previous chunk
 
-    // Create two temporary vectors to store the current elements of both chunks
-    const auto n1 = static_cast<size_t>(std::distance(first, middle));
-    const auto n2 = static_cast<size_t>(std::distance(middle, last));
-    using valueType = typename std::iterator_traits<srcIt>::value_type;
-    std::vector<valueType> arrayLeft(n1), arrayRight(n2);
-    std::copy(first, middle, arrayLeft.begin());
-    std::copy(middle, last, arrayRight.begin());
+template <typename srcIt, typename functor>
+auto par_unique_flags(srcIt first, srcIt last, functor func, std::vector<char>& kept, size_t chunkSize) -> std::vector<size_t> {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    kept.assign(n, 0);
+    auto futures = std::vector<std::future<size_t>>{};
+    futures.reserve(n / chunkSize + 1);
 
-    // Initialise indices
-    auto helperLeft(arrayLeft.begin()), helperLeftEnd(arrayLeft.end()), helperRight(arrayRight.begin()), helperRightEnd(arrayRight.end());
-    auto current(first);
+    // Create a table of futures to flag the elements of each chunk asynchronously
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &func, &kept] () -> size_t {
+            auto count = size_t{0};
+            for (auto i = startId; i < stopId; ++i) {
+                kept[i] = (i == 0 || !func(*(first + (i - 1)), *(first + i))) ? 1 : 0;
+                count += kept[i];
+            }
+            return count;
+        });
+        futures.emplace_back(std::move(future));
+    }
 
-    // Merge sort by comparing the elements of the temporary arrays
-    while (helperLeft != helperLeftEnd && helperRight != helperRightEnd) {
+    auto keptOffsets = std::vector<size_t>{0};
+    for (auto& future : futures)
+        keptOffsets.push_back(keptOffsets.back() + future.get());
+    return keptOffsets;
+}
 
-        if(func(*helperLeft, *helperRight)){
-            *current = *helperLeft;
-            helperLeft=std::next(helperLeft);
-        }
+} // namespace detail
 
-        else{
-            *current = *helperRight;
-            helperRight=std::next(helperRight);
-        }
+// Parallel version of std::unique_copy
 
-        current=std::next(current);
+template <typename srcIt, typename dstIt, typename functor>
+auto par_unique_copy(srcIt first, srcIt last, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= chunkSize) {
+        return std::unique_copy(first, last, dst, func);
     }
+    auto kept = std::vector<char>{};
+    const auto keptOffsets = detail::par_unique_flags(first, last, func, kept, chunkSize);
 
-    // Copy the remaining  elements of the left array
-    while(helperLeft != helperLeftEnd){
-        *current = *helperLeft;
-        helperLeft=std::next(helperLeft);
-        current=std::next(current);
+    // Create a table of futures to copy the kept elements of each chunk asynchronously
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(keptOffsets.size());
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto chunkDst = std::next(dst, keptOffsets[chunkId]);
+        auto future = std::async(std::launch::async, [=, &kept] () mutable {
+            for (auto i = startId; i < stopId; ++i) {
+                if (kept[i])
+                    *chunkDst++ = *(first + i);
+            }
+        });
+        futures.emplace_back(std::move(future));
     }
+    for (auto& future : futures)
+        future.wait();
+
+    return std::next(dst, keptOffsets.back());
+}
+
+template <typename srcIt, typename dstIt>
+auto par_unique_copy(srcIt first, srcIt last, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_unique_copy(first, last, dst, std::equal_to<valueType>(), chunkSize);
 }
 
+// Parallel version of std::unique
+// Caution: all the elements stored after the returned iterator are in undefined state. This method
+// is only recommended if followed by erase
+
 template <typename srcIt, typename functor>
-auto par_sort(srcIt first, srcIt last,functor func, size_t chunkSize) -> void {
+auto par_unique(srcIt first, srcIt last, functor func, size_t chunkSize) -> srcIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
     const auto n = static_cast<size_t>(std::distance(first, last));
     if (n <= chunkSize) {
-        std::sort(first, last, func);
-        return;
+        return std::unique(first, last, func);
     }
-    const auto srcMiddle = std::next(first, n / 2);
-
-    // Create a new task to treat the first part
-    auto future = std::async(std::launch::async, [=, &func] {
-        par_sort(first, srcMiddle, func, chunkSize);
-    });
-
-    // Treat the second part recursively
-    par_sort(srcMiddle, last, func, chunkSize);
-    future.wait();
+    auto kept = std::vector<char>{};
+    const auto keptOffsets = detail::par_unique_flags(first, last, func, kept, chunkSize);
+
+    // Chunks cannot be compacted in place concurrently: move the kept elements to a scratch buffer
+    auto buffer = std::vector<valueType>(keptOffsets.back());
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(keptOffsets.size());
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto chunkDst = buffer.begin() + keptOffsets[chunkId];
+        auto future = std::async(std::launch::async, [=, &kept] () mutable {
+            for (auto i = startId; i < stopId; ++i) {
+                if (kept[i])
+                    *chunkDst++ = std::move(*(first + i));
+            }
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+    par_copy(std::make_move_iterator(buffer.begin()), std::make_move_iterator(buffer.end()), first, chunkSize);
 
-    // Merge the two sorted parts
-    par_merge(first, srcMiddle, last, func);
+    return std::next(first, keptOffsets.back());
 }
 
-// Perform a merge of two sorted containers
 template <typename srcIt>
-auto par_merge(srcIt first, srcIt middle, srcIt last) -> void {
-
-    // Create two temporary vectors to store the current elements of both chunks
-    const auto n1 = static_cast<size_t>(std::distance(first, middle));
-    const auto n2 = static_cast<size_t>(std::distance(middle, last));
+auto par_unique(srcIt first, srcIt last, size_t chunkSize) -> srcIt {
     using valueType = typename std::iterator_traits<srcIt>::value_type;
-    std::vector<valueType> arrayLeft(n1), arrayRight(n2);
-    std::copy(first, middle, arrayLeft.begin());
-    std::copy(middle, last, arrayRight.begin());
+    return par_unique(first, last, std::equal_to<valueType>(), chunkSize);
+}
 
-     // Initialise indices
-    auto helperLeft(arrayLeft.begin()), helperLeftEnd(arrayLeft.end()), helperRight(arrayRight.begin()), helperRightEnd(arrayRight.end());
-    auto current(first);
+namespace detail {
+
+// Find how many elements of the first sorted range precede the element of rank outputId in the merge
+// of both ranges (the merge path co-rank). Ties are resolved in favour of the first range
+
+template <typename srcIt1, typename srcIt2, typename functor>
+auto par_merge_corank(srcIt1 first1, size_t n1, srcIt2 first2, size_t n2, size_t outputId, functor func) -> size_t {
+    auto low = outputId > n2 ? outputId - n2 : size_t{0};
+    auto high = std::min(outputId, n1);
+    while (low < high) {
+        const auto middle = low + (high - low) / 2;
+        if (!func(*(first2 + (outputId - middle - 1)), *(first1 + middle)))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
 
-    // Merge sort by comparing the elements of the temporary arrays
-    while (helperLeft != helperLeftEnd && helperRight != helperRightEnd) {
+// Sequential merge that moves each element into the output. The comparator is called on the source
+// elements themselves rather than through move iterators, so a comparator taking its arguments by value
+// copies them instead of moving them out
 
-        if(*helperLeft <= *helperRight){
-            *current = *helperLeft;
-            helperLeft=std::next(helperLeft);
-        }
+template <typename srcIt, typename dstIt, typename functor>
+auto par_move_merge(srcIt first1, srcIt last1, srcIt first2, srcIt last2, dstIt dst, functor func) -> dstIt {
+    while (first1 != last1 && first2 != last2) {
+        if (func(*first2, *first1))
+            *dst++ = std::move(*first2++);
+        else
+            *dst++ = std::move(*first1++);
+    }
+    dst = std::move(first1, last1, dst);
+    return std::move(first2, last2, dst);
+}
 
-        else{
-            *current = *helperRight;
-            helperRight=std::next(helperRight);
-        }
+} // namespace detail
+
+// Parallel version of std::merge
+// The output is split into chunks and the input subranges feeding each chunk are found by co-ranking
 
-        current=std::next(current);
+template <typename srcIt1, typename srcIt2, typename dstIt, typename functor>
+auto par_merge(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    const auto n1 = static_cast<size_t>(std::distance(first1, last1));
+    const auto n2 = static_cast<size_t>(std::distance(first2, last2));
+    const auto n = n1 + n2;
+    if (n <= chunkSize) {
+        return std::merge(first1, last1, first2, last2, dst, func);
     }
 
-    // Copy the remaining  elements of the left array
-    while(helperLeft != helperLeftEnd){
-        *current = *helperLeft;
-        helperLeft=std::next(helperLeft);
-        current=std::next(current);
+    // Locate all the split points before merging since the inputs may be moved from
+    auto splits = std::vector<size_t>{};
+    splits.reserve(n / chunkSize + 2);
+    for (size_t startId = 0; startId < n; startId += chunkSize)
+        splits.push_back(detail::par_merge_corank(first1, n1, first2, n2, startId, func));
+    splits.push_back(n1);
+
+    // Create a table of futures to produce each chunk of the output asynchronously
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(splits.size());
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        const auto start1 = splits[chunkId], stop1 = splits[chunkId + 1];
+        auto future = std::async(std::launch::async, [=, &func] {
+            std::merge(first1 + start1, first1 + stop1, first2 + (startId - start1), first2 + (stopId - stop1),
+                       std::next(dst, startId), func);
+        });
+        futures.emplace_back(std::move(future));
     }
+    for (auto& future : futures)
+        future.wait();
+
+    return std::next(dst, n);
 }
 
-template <typename srcIt>
-auto par_sort(srcIt first, srcIt last, size_t chunkSize) -> void {
+template <typename srcIt1, typename srcIt2, typename dstIt>
+auto par_merge(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt1>::value_type;
+    return par_merge(first1, last1, first2, last2, dst, std::less<valueType>(), chunkSize);
+}
+
+// Parallel version of std::inplace_merge
+
+template <typename srcIt, typename functor>
+auto par_inplace_merge(srcIt first, srcIt middle, srcIt last, functor func, size_t chunkSize) -> void {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
     const auto n = static_cast<size_t>(std::distance(first, last));
     if (n <= chunkSize) {
-        std::sort(first, last);
+        std::inplace_merge(first, middle, last, func);
         return;
     }
-    const auto srcMiddle = std::next(first, n / 2);
 
-    // Create a new task to treat the first part
+    // Move both sorted parts to a temporary buffer and locate all the split points of the merge
+    const auto n1 = static_cast<size_t>(std::distance(first, middle));
+    const auto n2 = n - n1;
+    auto buffer = std::vector<valueType>(n);
+    par_copy(std::make_move_iterator(first), std::make_move_iterator(last), buffer.begin(), chunkSize);
+    const auto first1 = buffer.begin();
+    const auto first2 = buffer.begin() + n1;
+    auto splits = std::vector<size_t>{};
+    splits.reserve(n / chunkSize + 2);
+    for (size_t startId = 0; startId < n; startId += chunkSize)
+        splits.push_back(detail::par_merge_corank(first1, n1, first2, n2, startId, func));
+    splits.push_back(n1);
+
+    // Create a table of futures to merge each chunk back into the container asynchronously
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(splits.size());
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        const auto start1 = splits[chunkId], stop1 = splits[chunkId + 1];
+        auto future = std::async(std::launch::async, [=, &func] {
+            detail::par_move_merge(first1 + start1, first1 + stop1, first2 + (startId - start1), first2 + (stopId - stop1),
+                                   std::next(first, startId), func);
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+}
+
+template <typename srcIt>
+auto par_inplace_merge(srcIt first, srcIt middle, srcIt last, size_t chunkSize) -> void {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    par_inplace_merge(first, middle, last, std::less<valueType>(), chunkSize);
+}
+
+namespace detail {
+
+// Output ranks of the sorted sequences merged by par_kway_merge: an element compares by value, then by the
+// index of its sequence, then by its position, so that every element has a distinct rank and the merge is
+// stable. Returns the number of elements of each sequence that precede the element of rank outputId, found
+// by bisecting a window [lower, upper] of candidate splits per sequence around the middle element of the
+// widest window
+
+template <typename srcIt, typename functor>
+auto par_kway_splits(const std::vector<std::pair<srcIt, srcIt>>& ranges, size_t outputId, functor func) -> std::vector<size_t> {
+    const auto k = ranges.size();
+    auto lower = std::vector<size_t>(k, 0);
+    auto upper = std::vector<size_t>(k);
+    for (size_t rangeId = 0; rangeId < k; ++rangeId)
+        upper[rangeId] = static_cast<size_t>(std::distance(ranges[rangeId].first, ranges[rangeId].second));
+
+    auto counts = std::vector<size_t>(k);
+    while (true) {
+        auto pivotRange = k;
+        for (size_t rangeId = 0; rangeId < k; ++rangeId) {
+            if (upper[rangeId] > lower[rangeId] && (pivotRange == k || upper[rangeId] - lower[rangeId] > upper[pivotRange] - lower[pivotRange]))
+                pivotRange = rangeId;
+        }
+        if (pivotRange == k)
+            return lower;
+
+        // Rank of the pivot: the elements of each sequence that precede it
+        const auto pivotId = lower[pivotRange] + (upper[pivotRange] - lower[pivotRange]) / 2;
+        const auto& pivot = *std::next(ranges[pivotRange].first, pivotId);
+        auto rank = size_t{0};
+        for (size_t rangeId = 0; rangeId < k; ++rangeId) {
+            const auto first = ranges[rangeId].first;
+            const auto last = ranges[rangeId].second;
+            if (rangeId < pivotRange)
+                counts[rangeId] = static_cast<size_t>(std::distance(first, std::upper_bound(first, last, pivot, func)));
+            else if (rangeId > pivotRange)
+                counts[rangeId] = static_cast<size_t>(std::distance(first, std::lower_bound(first, last, pivot, func)));
+            else
+                counts[rangeId] = pivotId;
+            rank += counts[rangeId];
+        }
+        if (rank == outputId)
+            return counts;
+
+        // The element of rank outputId comes after the pivot: the splits are at least the counts (past the
+        // pivot itself in its sequence), and at most the counts otherwise
+        for (size_t rangeId = 0; rangeId < k; ++rangeId) {
+            if (rank < outputId)
+                lower[rangeId] = std::max(lower[rangeId], counts[rangeId] + (rangeId == pivotRange ? 1 : 0));
+            else
+                upper[rangeId] = std::min(upper[rangeId], counts[rangeId]);
+        }
+    }
+}
+
+// Sequential stable merge of sorted sequences with a loser tree: the inner nodes keep the loser of each
+// match, so that replacing the winner only replays the matches on the path from its leaf to the root
+
+template <typename srcIt, typename dstIt, typename functor>
+auto par_loser_tree_merge(std::vector<std::pair<srcIt, srcIt>> ranges, dstIt dst, functor func) -> dstIt {
+    const auto k = ranges.size();
+    auto leaves = size_t{1};
+    while (leaves < k)
+        leaves *= 2;
+
+    // Exhausted sequences (and the padding leaves) lose every match, ties are won by the first sequence
+    const auto beats = [&](size_t a, size_t b) -> bool {
+        if (a >= k || ranges[a].first == ranges[a].second)
+            return false;
+        if (b >= k || ranges[b].first == ranges[b].second)
+            return true;
+        if (func(*ranges[a].first, *ranges[b].first))
+            return true;
+        if (func(*ranges[b].first, *ranges[a].first))
+            return false;
+        return a < b;
+    };
+
+    // Play the initial matches bottom-up
+    auto losers = std::vector<size_t>(leaves);
+    auto winners = std::vector<size_t>(2 * leaves);
+    for (size_t leafId = 0; leafId < leaves; ++leafId)
+        winners[leaves + leafId] = leafId;
+    for (auto node = leaves - 1; node > 0; --node) {
+        const auto left = winners[2 * node];
+        const auto right = winners[2 * node + 1];
+        winners[node] = beats(right, left) ? right : left;
+        losers[node] = beats(right, left) ? left : right;
+    }
+
+    auto winner = winners[1];
+    while (winner < k && ranges[winner].first != ranges[winner].second) {
+        *dst = *ranges[winner].first;
+        ++dst;
+        ++ranges[winner].first;
+        for (auto node = (leaves + winner) / 2; node > 0; node /= 2) {
+            if (beats(losers[node], winner))
+                std::swap(losers[node], winner);
+        }
+    }
+    return dst;
+}
+
+} // namespace detail
+
+// Parallel stable merge of several sorted sequences: the output is cut into chunks whose splits in every
+// sequence are found by multi-sequence selection, then each chunk is merged with a loser tree by its own task
+
+template <typename srcIt, typename dstIt, typename functor>
+auto par_kway_merge(const std::vector<std::pair<srcIt, srcIt>>& ranges, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    auto n = size_t{0};
+    for (const auto& range : ranges)
+        n += static_cast<size_t>(std::distance(range.first, range.second));
+    if (n <= chunkSize)
+        return detail::par_loser_tree_merge(ranges, dst, func);
+
+    // Find the splits of every chunk asynchronously
+    auto splitFutures = std::vector<std::future<std::vector<size_t>>>{};
+    splitFutures.reserve(n / chunkSize);
+    for (size_t startId = chunkSize; startId < n; startId += chunkSize) {
+        auto future = std::async(std::launch::async, [=, &ranges, &func] {
+            return detail::par_kway_splits(ranges, startId, func);
+        });
+        splitFutures.emplace_back(std::move(future));
+    }
+    auto splits = std::vector<std::vector<size_t>>{std::vector<size_t>(ranges.size(), 0)};
+    for (auto& future : splitFutures)
+        splits.push_back(future.get());
+
+    // Create a table of futures to merge each chunk asynchronously
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(splits.size());
+    for (size_t chunkId = 0; chunkId < splits.size(); ++chunkId) {
+        auto future = std::async(std::launch::async, [=, &ranges, &splits, &func] {
+            auto chunkRanges = std::vector<std::pair<srcIt, srcIt>>{};
+            chunkRanges.reserve(ranges.size());
+            for (size_t rangeId = 0; rangeId < ranges.size(); ++rangeId) {
+                const auto first = std::next(ranges[rangeId].first, splits[chunkId][rangeId]);
+                const auto last = chunkId + 1 < splits.size() ? std::next(ranges[rangeId].first, splits[chunkId + 1][rangeId]) : ranges[rangeId].second;
+                chunkRanges.emplace_back(first, last);
+            }
+            detail::par_loser_tree_merge(chunkRanges, std::next(dst, chunkId * chunkSize), func);
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    return std::next(dst, n);
+}
+
+template <typename srcIt, typename dstIt>
+auto par_kway_merge(const std::vector<std::pair<srcIt, srcIt>>& ranges, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_kway_merge(ranges, dst, std::less<valueType>(), chunkSize);
+}
+
+// Parallel version of std::sort
+
+template <typename srcIt, typename functor>
+auto par_sort(srcIt first, srcIt last,functor func, size_t chunkSize) -> void {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= chunkSize) {
+        std::sort(first, last, func);
+        return;
+    }
+    const auto srcMiddle = std::next(first, n / 2);
+
+    // Create a new task to treat the first part
+    auto future = std::async(std::launch::async, [=, &func] {
+        par_sort(first, srcMiddle, func, chunkSize);
+    });
+
+    // Treat the second part recursively
+    par_sort(srcMiddle, last, func, chunkSize);
+    future.wait();
+
+    // Merge the two sorted parts
+    par_inplace_merge(first, srcMiddle, last, func, chunkSize);
+}
+
+template <typename srcIt>
+auto par_sort(srcIt first, srcIt last, size_t chunkSize) -> void {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= chunkSize) {
+        std::sort(first, last);
+        return;
+    }
+    const auto srcMiddle = std::next(first, n / 2);
+
+    // Create a new task to treat the first part
     auto future = std::async(std::launch::async, [=] {
         par_sort(first, srcMiddle, chunkSize);
     });
 
-    // Treat the second part recursively
-    par_sort(srcMiddle, last, chunkSize);
-    future.wait();
+    // Treat the second part recursively
+    par_sort(srcMiddle, last, chunkSize);
+    future.wait();
+
+    // Merge the two sorted parts
+    par_inplace_merge(first, srcMiddle, last, chunkSize);
+}
+
+// Parallel version of std::partition
+// Each chunk is partitioned locally, then the elements lying on the wrong side of the global partition
+// point are swapped pairwise by independent tasks
+
+template <typename srcIt, typename functor>
+auto par_partition(srcIt first, srcIt last, functor func, size_t chunkSize) -> srcIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= chunkSize) {
+        return std::partition(first, last, func);
+    }
+    using futureType = std::future<size_t>;
+    auto futures = std::vector<futureType>{};
+    futures.reserve(n / chunkSize + 1);
+
+    // Create a table of futures to partition each chunk asynchronously
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &func] () -> size_t {
+            auto chunkMiddle = std::partition(first + startId, first + stopId, func);
+            return static_cast<size_t>(std::distance(first, chunkMiddle));
+        });
+        futures.emplace_back(std::move(future));
+    }
+
+    auto chunkMiddles = std::vector<size_t>{};
+    chunkMiddles.reserve(futures.size());
+    auto partitionPoint = size_t{0};
+    for (size_t chunkId = 0; chunkId < futures.size(); ++chunkId) {
+        chunkMiddles.push_back(futures[chunkId].get());
+        partitionPoint += chunkMiddles.back() - chunkId * chunkSize;
+    }
+
+    // Collect the misplaced elements: rejected ones before the partition point and accepted ones after it
+    using indexRange = std::pair<size_t, size_t>;
+    auto rejectedRanges = std::vector<indexRange>{}, acceptedRanges = std::vector<indexRange>{};
+    auto rejectedOffsets = std::vector<size_t>{0}, acceptedOffsets = std::vector<size_t>{0};
+    for (size_t chunkId = 0; chunkId < chunkMiddles.size(); ++chunkId) {
+        const auto startId = chunkId * chunkSize;
+        const auto stopId = std::min(startId + chunkSize, n);
+        const auto middleId = chunkMiddles[chunkId];
+        if (middleId < std::min(stopId, partitionPoint)) {
+            rejectedRanges.emplace_back(middleId, std::min(stopId, partitionPoint));
+            rejectedOffsets.push_back(rejectedOffsets.back() + rejectedRanges.back().second - middleId);
+        }
+        if (std::max(startId, partitionPoint) < middleId) {
+            acceptedRanges.emplace_back(std::max(startId, partitionPoint), middleId);
+            acceptedOffsets.push_back(acceptedOffsets.back() + middleId - acceptedRanges.back().first);
+        }
+    }
+
+    // Swap the misplaced elements pairwise, each task handling a contiguous run of pairs
+    auto locate = [](const std::vector<indexRange>& ranges, const std::vector<size_t>& offsets, size_t rank) -> indexRange {
+        const auto rangeId = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), rank) - offsets.begin()) - 1;
+        return std::make_pair(rangeId, ranges[rangeId].first + rank - offsets[rangeId]);
+    };
+    const auto misplaced = rejectedOffsets.back();
+    auto swapFutures = std::vector<std::future<void>>{};
+    swapFutures.reserve(misplaced / chunkSize + 1);
+    for (size_t startRank = 0; startRank < misplaced; startRank += chunkSize) {
+        const auto stopRank = std::min(startRank + chunkSize, misplaced);
+        auto future = std::async(std::launch::async, [=, &rejectedRanges, &rejectedOffsets, &acceptedRanges, &acceptedOffsets] {
+            auto rejected = locate(rejectedRanges, rejectedOffsets, startRank);
+            auto accepted = locate(acceptedRanges, acceptedOffsets, startRank);
+            for (auto rank = startRank; rank < stopRank; ++rank) {
+                std::iter_swap(first + rejected.second, first + accepted.second);
+                if (++rejected.second == rejectedRanges[rejected.first].second && ++rejected.first < rejectedRanges.size())
+                    rejected.second = rejectedRanges[rejected.first].first;
+                if (++accepted.second == acceptedRanges[accepted.first].second && ++accepted.first < acceptedRanges.size())
+                    accepted.second = acceptedRanges[accepted.first].first;
+            }
+        });
+        swapFutures.emplace_back(std::move(future));
+    }
+    for (auto& future : swapFutures)
+        future.wait();
+
+    return std::next(first, partitionPoint);
+}
+
+// Parallel version of std::stable_partition
+// The predicate results are stored during a first pass counting the accepted elements of each chunk,
+// then every chunk moves its elements to their final place in a scratch buffer
+
+template <typename srcIt, typename functor>
+auto par_stable_partition(srcIt first, srcIt last, functor func, size_t chunkSize) -> srcIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= chunkSize) {
+        return std::stable_partition(first, last, func);
+    }
+    auto accepted = std::vector<char>(n);
+    auto futures = std::vector<std::future<size_t>>{};
+    futures.reserve(n / chunkSize + 1);
+
+    // Create a table of futures to evaluate the predicate on each chunk asynchronously
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &func, &accepted] () -> size_t {
+            auto count = size_t{0};
+            for (auto i = startId; i < stopId; ++i) {
+                accepted[i] = func(*(first + i)) ? 1 : 0;
+                count += accepted[i];
+            }
+            return count;
+        });
+        futures.emplace_back(std::move(future));
+    }
+
+    // Compute where the accepted and rejected elements of each chunk start
+    auto acceptedOffsets = std::vector<size_t>{0};
+    for (auto& future : futures)
+        acceptedOffsets.push_back(acceptedOffsets.back() + future.get());
+    const auto partitionPoint = acceptedOffsets.back();
+
+    // Move the elements of each chunk to the scratch buffer then move them back
+    auto buffer = std::vector<valueType>(n);
+    auto moveFutures = std::vector<std::future<void>>{};
+    moveFutures.reserve(futures.size());
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto acceptedDst = buffer.begin() + acceptedOffsets[chunkId];
+        auto rejectedDst = buffer.begin() + partitionPoint + (startId - acceptedOffsets[chunkId]);
+        auto future = std::async(std::launch::async, [=, &accepted] () mutable {
+            for (auto i = startId; i < stopId; ++i) {
+                if (accepted[i])
+                    *acceptedDst++ = std::move(*(first + i));
+                else
+                    *rejectedDst++ = std::move(*(first + i));
+            }
+        });
+        moveFutures.emplace_back(std::move(future));
+    }
+    for (auto& future : moveFutures)
+        future.wait();
+    par_copy(std::make_move_iterator(buffer.begin()), std::make_move_iterator(buffer.end()), first, chunkSize);
+
+    return std::next(first, partitionPoint);
+}
+
+// Parallel version of std::nth_element
+// Quickselect where each step partitions the range in parallel around the median of a regular sample
+
+template <typename srcIt, typename functor>
+auto par_nth_element(srcIt first, srcIt nth, srcIt last, functor func, size_t chunkSize) -> void {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    const auto maxSampleSize = size_t{127};
+    while (nth != last) {
+        const auto n = static_cast<size_t>(std::distance(first, last));
+        if (n <= chunkSize) {
+            std::nth_element(first, nth, last, func);
+            return;
+        }
+
+        // Pick the pivot as the median of the sample
+        const auto sampleSize = std::min(n, maxSampleSize);
+        auto sample = std::vector<valueType>{};
+        sample.reserve(sampleSize);
+        for (size_t i = 0; i < sampleSize; ++i)
+            sample.push_back(*std::next(first, i * n / sampleSize));
+        const auto sampleMiddle = sample.begin() + sampleSize / 2;
+        std::nth_element(sample.begin(), sampleMiddle, sample.end(), func);
+        const valueType pivot = *sampleMiddle;
+
+        // Split the range into elements lower than, equal to and greater than the pivot
+        const auto lowerLast = par_partition(first, last, [&](const valueType& a) {
+            return func(a, pivot);
+        }, chunkSize);
+        if (nth < lowerLast) {
+            last = lowerLast;
+            continue;
+        }
+        const auto upperFirst = par_partition(lowerLast, last, [&](const valueType& a) {
+            return !func(pivot, a);
+        }, chunkSize);
+        if (nth < upperFirst)
+            return;
+        first = upperFirst;
+    }
+}
+
+template <typename srcIt>
+auto par_nth_element(srcIt first, srcIt nth, srcIt last, size_t chunkSize) -> void {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    par_nth_element(first, nth, last, std::less<valueType>(), chunkSize);
+}
+
+// Parallel version of std::partial_sort
+
+template <typename srcIt, typename functor>
+auto par_partial_sort(srcIt first, srcIt middle, srcIt last, functor func, size_t chunkSize) -> void {
+    if (first == middle) {
+        return;
+    }
+
+    // Gather the smallest elements in the first part then sort it
+    par_nth_element(first, std::prev(middle), last, func, chunkSize);
+    par_sort(first, middle, func, chunkSize);
+}
+
+template <typename srcIt>
+auto par_partial_sort(srcIt first, srcIt middle, srcIt last, size_t chunkSize) -> void {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    par_partial_sort(first, middle, last, std::less<valueType>(), chunkSize);
+}
+
+// Parallel version of std::partial_sort_copy
+
+template <typename srcIt, typename dstIt, typename functor>
+auto par_partial_sort_copy(srcIt first, srcIt last, dstIt dstFirst, dstIt dstLast, functor func, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto k = std::min(n, static_cast<size_t>(std::distance(dstFirst, dstLast)));
+    if (n <= chunkSize || k == 0) {
+        return std::partial_sort_copy(first, last, dstFirst, dstLast, func);
+    }
+
+    // Only the k smallest elements of each chunk can make it to the destination
+    auto candidates = std::vector<valueType>{};
+    auto candidatesOffsets = std::vector<size_t>{0};
+    for (size_t startId = 0; startId < n; startId += chunkSize)
+        candidatesOffsets.push_back(candidatesOffsets.back() + std::min(k, std::min(startId + chunkSize, n) - startId));
+    candidates.resize(candidatesOffsets.back());
+
+    // Create a table of futures to select the candidates of each chunk asynchronously
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(candidatesOffsets.size());
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        const auto candidatesFirst = candidates.begin() + candidatesOffsets[chunkId];
+        const auto candidatesLast = candidates.begin() + candidatesOffsets[chunkId + 1];
+        auto future = std::async(std::launch::async, [=, &func] {
+            std::partial_sort_copy(first + startId, first + stopId, candidatesFirst, candidatesLast, func);
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    // Select and sort the k smallest candidates
+    const auto candidatesMiddle = candidates.begin() + k;
+    par_partial_sort(candidates.begin(), candidatesMiddle, candidates.end(), func, chunkSize);
+    par_copy(candidates.begin(), candidatesMiddle, dstFirst, chunkSize);
+    return std::next(dstFirst, k);
+}
+
+template <typename srcIt, typename dstIt>
+auto par_partial_sort_copy(srcIt first, srcIt last, dstIt dstFirst, dstIt dstLast, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_partial_sort_copy(first, last, dstFirst, dstLast, std::less<valueType>(), chunkSize);
+}
+
+namespace detail {
+
+// Split two sorted ranges into pairs of subranges that can be processed independently. Split points are
+// taken at regular ranks of the merged ranges then moved back to the first occurrence of the value found
+// there, so that equivalent elements of both ranges always end up in the same pair of subranges
+
+template <typename srcIt1, typename srcIt2, typename functor>
+auto par_sorted_splits(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, functor func, size_t chunkSize) -> std::vector<std::pair<size_t, size_t>> {
+    const auto n1 = static_cast<size_t>(std::distance(first1, last1));
+    const auto n2 = static_cast<size_t>(std::distance(first2, last2));
+    auto splits = std::vector<std::pair<size_t, size_t>>{std::make_pair(size_t{0}, size_t{0})};
+    for (auto outputId = chunkSize; outputId < n1 + n2; outputId += chunkSize) {
+        const auto id1 = detail::par_merge_corank(first1, n1, first2, n2, outputId, func);
+        const auto id2 = outputId - id1;
+        auto split = std::pair<size_t, size_t>{};
+        if (id1 < n1 && (id2 == n2 || !func(*(first2 + id2), *(first1 + id1)))) {
+            const auto& value = *(first1 + id1);
+            split.first = static_cast<size_t>(std::lower_bound(first1, first1 + id1, value, func) - first1);
+            split.second = static_cast<size_t>(std::lower_bound(first2, last2, value, func) - first2);
+        }
+        else {
+            const auto& value = *(first2 + id2);
+            split.first = static_cast<size_t>(std::lower_bound(first1, last1, value, func) - first1);
+            split.second = static_cast<size_t>(std::lower_bound(first2, first2 + id2, value, func) - first2);
+        }
+        if (split != splits.back())
+            splits.push_back(split);
+    }
+    splits.push_back(std::make_pair(n1, n2));
+    return splits;
+}
+
+// Apply a set operation on each pair of independent subranges of two sorted ranges, then copy the partial
+// results to the destination
+
+template <typename srcIt1, typename srcIt2, typename dstIt, typename functor, typename setFunctor>
+auto par_set_operation(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, functor func, setFunctor setFunc, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt1>::value_type;
+    const auto splits = par_sorted_splits(first1, last1, first2, last2, func, chunkSize);
+
+    // Create a table of futures to handle each pair of subranges asynchronously
+    auto futures = std::vector<std::future<std::vector<valueType>>>{};
+    futures.reserve(splits.size());
+    for (size_t splitId = 0; splitId + 1 < splits.size(); ++splitId) {
+        const auto start = splits[splitId], stop = splits[splitId + 1];
+        auto future = std::async(std::launch::async, [=, &setFunc] () -> std::vector<valueType> {
+            auto result = std::vector<valueType>{};
+            setFunc(first1 + start.first, first1 + stop.first, first2 + start.second, first2 + stop.second, std::back_inserter(result));
+            return result;
+        });
+        futures.emplace_back(std::move(future));
+    }
+    auto results = std::vector<std::vector<valueType>>{};
+    results.reserve(futures.size());
+    auto resultOffsets = std::vector<size_t>{0};
+    for (auto& future : futures) {
+        results.push_back(future.get());
+        resultOffsets.push_back(resultOffsets.back() + results.back().size());
+    }
+
+    // Copy the partial results to the destination asynchronously
+    auto copyFutures = std::vector<std::future<void>>{};
+    copyFutures.reserve(results.size());
+    for (size_t resultId = 0; resultId < results.size(); ++resultId) {
+        auto resultDst = std::next(dst, resultOffsets[resultId]);
+        auto future = std::async(std::launch::async, [=, &results] {
+            std::move(results[resultId].begin(), results[resultId].end(), resultDst);
+        });
+        copyFutures.emplace_back(std::move(future));
+    }
+    for (auto& future : copyFutures)
+        future.wait();
+
+    return std::next(dst, resultOffsets.back());
+}
+
+} // namespace detail
+
+// Parallel version of std::set_union
+
+template <typename srcIt1, typename srcIt2, typename dstIt, typename functor>
+auto par_set_union(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    using inserter = std::back_insert_iterator<std::vector<typename std::iterator_traits<srcIt1>::value_type>>;
+    return detail::par_set_operation(first1, last1, first2, last2, dst, func, [&func](srcIt1 f1, srcIt1 l1, srcIt2 f2, srcIt2 l2, inserter out) {
+        std::set_union(f1, l1, f2, l2, out, func);
+    }, chunkSize);
+}
+
+template <typename srcIt1, typename srcIt2, typename dstIt>
+auto par_set_union(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt1>::value_type;
+    return par_set_union(first1, last1, first2, last2, dst, std::less<valueType>(), chunkSize);
+}
+
+// Parallel version of std::set_intersection
+
+template <typename srcIt1, typename srcIt2, typename dstIt, typename functor>
+auto par_set_intersection(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    using inserter = std::back_insert_iterator<std::vector<typename std::iterator_traits<srcIt1>::value_type>>;
+    return detail::par_set_operation(first1, last1, first2, last2, dst, func, [&func](srcIt1 f1, srcIt1 l1, srcIt2 f2, srcIt2 l2, inserter out) {
+        std::set_intersection(f1, l1, f2, l2, out, func);
+    }, chunkSize);
+}
+
+template <typename srcIt1, typename srcIt2, typename dstIt>
+auto par_set_intersection(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt1>::value_type;
+    return par_set_intersection(first1, last1, first2, last2, dst, std::less<valueType>(), chunkSize);
+}
+
+// Parallel version of std::set_difference
+
+template <typename srcIt1, typename srcIt2, typename dstIt, typename functor>
+auto par_set_difference(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    using inserter = std::back_insert_iterator<std::vector<typename std::iterator_traits<srcIt1>::value_type>>;
+    return detail::par_set_operation(first1, last1, first2, last2, dst, func, [&func](srcIt1 f1, srcIt1 l1, srcIt2 f2, srcIt2 l2, inserter out) {
+        std::set_difference(f1, l1, f2, l2, out, func);
+    }, chunkSize);
+}
+
+template <typename srcIt1, typename srcIt2, typename dstIt>
+auto par_set_difference(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt1>::value_type;
+    return par_set_difference(first1, last1, first2, last2, dst, std::less<valueType>(), chunkSize);
+}
+
+// Parallel version of std::includes
+
+template <typename srcIt1, typename srcIt2, typename functor>
+auto par_includes(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, functor func, size_t chunkSize) -> bool {
+    const auto splits = detail::par_sorted_splits(first1, last1, first2, last2, func, chunkSize);
+
+    // Create a table of futures to check each pair of subranges asynchronously
+    auto futures = std::vector<std::future<bool>>{};
+    futures.reserve(splits.size());
+    for (size_t splitId = 0; splitId + 1 < splits.size(); ++splitId) {
+        const auto start = splits[splitId], stop = splits[splitId + 1];
+        auto future = std::async(std::launch::async, [=, &func] () -> bool {
+            return std::includes(first1 + start.first, first1 + stop.first, first2 + start.second, first2 + stop.second, func);
+        });
+        futures.emplace_back(std::move(future));
+    }
+
+    auto included = true;
+    for (auto& future : futures)
+        included = future.get() && included;
+    return included;
+}
+
+template <typename srcIt1, typename srcIt2>
+auto par_includes(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, size_t chunkSize) -> bool {
+    using valueType = typename std::iterator_traits<srcIt1>::value_type;
+    return par_includes(first1, last1, first2, last2, std::less<valueType>(), chunkSize);
+}
+
+namespace detail {
+
+// Exponential search of the first element of a partitioned range that does not satisfy the predicate,
+// starting from the beginning of the range. Cheap when the result is close to the start
+
+template <typename srcIt, typename functor>
+auto par_gallop(srcIt first, srcIt last, functor func) -> srcIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    auto low = size_t{0}, high = size_t{1};
+    while (high <= n && func(*(first + (high - 1)))) {
+        low = high;
+        high *= 2;
+    }
+    return std::partition_point(first + low, first + std::min(high, n), func);
+}
+
+// Apply a batch search to chunks of queries in parallel
+
+template <typename srcIt, typename dstIt, typename functor>
+auto par_search_batch(srcIt queriesFirst, srcIt queriesLast, dstIt dst, functor func, size_t chunkSize) -> void {
+    const auto n = static_cast<size_t>(std::distance(queriesFirst, queriesLast));
+    if (n <= chunkSize) {
+        func(queriesFirst, queriesLast, dst);
+        return;
+    }
+    const auto srcMiddle = std::next(queriesFirst, n / 2);
+
+    // Create a new task to treat the first part
+    auto future = std::async(std::launch::async, [=, &func] {
+        par_search_batch(queriesFirst, srcMiddle, dst, func, chunkSize);
+    });
+
+    // Treat the second part recursively
+    const auto dstMiddle = std::next(dst, n / 2);
+    par_search_batch(srcMiddle, queriesLast, dstMiddle, func, chunkSize);
+    future.wait();
+}
+
+} // namespace detail
+
+// Parallel batched version of std::lower_bound: writes the lower bound of each query to dst
+
+template <typename srcIt, typename queryIt, typename dstIt, typename functor>
+auto par_lower_bound_many(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    detail::par_search_batch(queriesFirst, queriesLast, dst, [=, &func](queryIt chunkFirst, queryIt chunkLast, dstIt chunkDst) {
+        for (auto it = chunkFirst; it != chunkLast; it = std::next(it), chunkDst = std::next(chunkDst))
+            *chunkDst = std::lower_bound(first, last, *it, func);
+    }, chunkSize);
+    return std::next(dst, std::distance(queriesFirst, queriesLast));
+}
+
+template <typename srcIt, typename queryIt, typename dstIt>
+auto par_lower_bound_many(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_lower_bound_many(first, last, queriesFirst, queriesLast, dst, std::less<valueType>(), chunkSize);
+}
+
+// Same as par_lower_bound_many for queries sorted in the order of the range: each chunk of queries is
+// searched incrementally from the previous result
+
+template <typename srcIt, typename queryIt, typename dstIt, typename functor>
+auto par_lower_bound_many_sorted(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    using queryType = typename std::iterator_traits<queryIt>::value_type;
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    detail::par_search_batch(queriesFirst, queriesLast, dst, [=, &func](queryIt chunkFirst, queryIt chunkLast, dstIt chunkDst) {
+        auto position = first;
+        for (auto it = chunkFirst; it != chunkLast; it = std::next(it), chunkDst = std::next(chunkDst)) {
+            const queryType& query = *it;
+            position = detail::par_gallop(position, last, [&](const valueType& a) {
+                return func(a, query);
+            });
+            *chunkDst = position;
+        }
+    }, chunkSize);
+    return std::next(dst, std::distance(queriesFirst, queriesLast));
+}
+
+template <typename srcIt, typename queryIt, typename dstIt>
+auto par_lower_bound_many_sorted(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_lower_bound_many_sorted(first, last, queriesFirst, queriesLast, dst, std::less<valueType>(), chunkSize);
+}
+
+// Parallel batched version of std::upper_bound: writes the upper bound of each query to dst
+
+template <typename srcIt, typename queryIt, typename dstIt, typename functor>
+auto par_upper_bound_many(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    detail::par_search_batch(queriesFirst, queriesLast, dst, [=, &func](queryIt chunkFirst, queryIt chunkLast, dstIt chunkDst) {
+        for (auto it = chunkFirst; it != chunkLast; it = std::next(it), chunkDst = std::next(chunkDst))
+            *chunkDst = std::upper_bound(first, last, *it, func);
+    }, chunkSize);
+    return std::next(dst, std::distance(queriesFirst, queriesLast));
+}
+
+template <typename srcIt, typename queryIt, typename dstIt>
+auto par_upper_bound_many(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_upper_bound_many(first, last, queriesFirst, queriesLast, dst, std::less<valueType>(), chunkSize);
+}
+
+// Same as par_upper_bound_many for queries sorted in the order of the range
+
+template <typename srcIt, typename queryIt, typename dstIt, typename functor>
+auto par_upper_bound_many_sorted(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    using queryType = typename std::iterator_traits<queryIt>::value_type;
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    detail::par_search_batch(queriesFirst, queriesLast, dst, [=, &func](queryIt chunkFirst, queryIt chunkLast, dstIt chunkDst) {
+        auto position = first;
+        for (auto it = chunkFirst; it != chunkLast; it = std::next(it), chunkDst = std::next(chunkDst)) {
+            const queryType& query = *it;
+            position = detail::par_gallop(position, last, [&](const valueType& a) {
+                return !func(query, a);
+            });
+            *chunkDst = position;
+        }
+    }, chunkSize);
+    return std::next(dst, std::distance(queriesFirst, queriesLast));
+}
+
+template <typename srcIt, typename queryIt, typename dstIt>
+auto par_upper_bound_many_sorted(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_upper_bound_many_sorted(first, last, queriesFirst, queriesLast, dst, std::less<valueType>(), chunkSize);
+}
+
+// Parallel batched version of std::equal_range: writes the pair of bounds of each query to dst
+
+template <typename srcIt, typename queryIt, typename dstIt, typename functor>
+auto par_equal_range_many(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    detail::par_search_batch(queriesFirst, queriesLast, dst, [=, &func](queryIt chunkFirst, queryIt chunkLast, dstIt chunkDst) {
+        for (auto it = chunkFirst; it != chunkLast; it = std::next(it), chunkDst = std::next(chunkDst))
+            *chunkDst = std::equal_range(first, last, *it, func);
+    }, chunkSize);
+    return std::next(dst, std::distance(queriesFirst, queriesLast));
+}
+
+template <typename srcIt, typename queryIt, typename dstIt>
+auto par_equal_range_many(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_equal_range_many(first, last, queriesFirst, queriesLast, dst, std::less<valueType>(), chunkSize);
+}
+
+// Same as par_equal_range_many for queries sorted in the order of the range
+
+template <typename srcIt, typename queryIt, typename dstIt, typename functor>
+auto par_equal_range_many_sorted(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    using queryType = typename std::iterator_traits<queryIt>::value_type;
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    detail::par_search_batch(queriesFirst, queriesLast, dst, [=, &func](queryIt chunkFirst, queryIt chunkLast, dstIt chunkDst) {
+        auto position = first;
+        for (auto it = chunkFirst; it != chunkLast; it = std::next(it), chunkDst = std::next(chunkDst)) {
+            const queryType& query = *it;
+            position = detail::par_gallop(position, last, [&](const valueType& a) {
+                return func(a, query);
+            });
+            auto upper = detail::par_gallop(position, last, [&](const valueType& a) {
+                return !func(query, a);
+            });
+            *chunkDst = std::make_pair(position, upper);
+        }
+    }, chunkSize);
+    return std::next(dst, std::distance(queriesFirst, queriesLast));
+}
+
+template <typename srcIt, typename queryIt, typename dstIt>
+auto par_equal_range_many_sorted(srcIt first, srcIt last, queryIt queriesFirst, queryIt queriesLast, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_equal_range_many_sorted(first, last, queriesFirst, queriesLast, dst, std::less<valueType>(), chunkSize);
+}
+
+namespace detail {
+
+// Number of nodes in the subtree of a node of an Eytzinger layout (0-based breadth-first order of a
+// complete binary tree) holding n elements
+
+inline auto par_eytzinger_subtree_size(size_t node, size_t n) -> size_t {
+    auto size = size_t{0};
+    for (auto low = node + 1, high = node + 1; low <= n; low = 2 * low, high = 2 * high + 1)
+        size += std::min(high, n) - low + 1;
+    return size;
+}
+
+// Fill the subtree of a node of an Eytzinger layout with sorted elements starting at the given rank,
+// following an in-order traversal. Returns the rank following the last element used
+
+template <typename srcIt, typename dstIt>
+auto par_eytzinger_inorder(srcIt first, dstIt dst, size_t n, size_t node, size_t rank) -> size_t {
+    if (node >= n) {
+        return rank;
+    }
+    rank = par_eytzinger_inorder(first, dst, n, 2 * node + 1, rank);
+    *(dst + node) = *(first + rank);
+    return par_eytzinger_inorder(first, dst, n, 2 * node + 2, rank + 1);
+}
+
+template <typename srcIt, typename dstIt>
+auto par_eytzinger_fill(srcIt first, dstIt dst, size_t n, size_t node, size_t rank, size_t chunkSize) -> size_t {
+    if (node >= n || par_eytzinger_subtree_size(node, n) <= chunkSize) {
+        return par_eytzinger_inorder(first, dst, n, node, rank);
+    }
+    const auto leftSize = par_eytzinger_subtree_size(2 * node + 1, n);
+    *(dst + node) = *(first + (rank + leftSize));
+
+    // Create a new task to treat the left subtree
+    auto future = std::async(std::launch::async, [=] {
+        par_eytzinger_fill(first, dst, n, 2 * node + 1, rank, chunkSize);
+    });
+
+    // Treat the right subtree recursively
+    const auto stopRank = par_eytzinger_fill(first, dst, n, 2 * node + 2, rank + leftSize + 1, chunkSize);
+    future.wait();
+    return stopRank;
+}
+
+} // namespace detail
+
+// Copy a sorted range to dst in Eytzinger layout, the breadth-first order of a complete binary search
+// tree: the top levels of the tree share a few cache lines and a search touches one node per level
+
+template <typename srcIt, typename dstIt>
+auto par_eytzinger_layout(srcIt first, srcIt last, dstIt dst, size_t chunkSize) -> dstIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    detail::par_eytzinger_fill(first, dst, n, 0, 0, chunkSize);
+    return std::next(dst, n);
+}
+
+// Parallel batched lower bound search in a range in Eytzinger layout: writes for each query an iterator to
+// the lower bound inside the layout, or layoutLast if all the elements are lower than the query
+
+template <typename srcIt, typename queryIt, typename dstIt, typename functor>
+auto par_eytzinger_lower_bound_many(srcIt layoutFirst, srcIt layoutLast, queryIt queriesFirst, queryIt queriesLast, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    const auto n = static_cast<size_t>(std::distance(layoutFirst, layoutLast));
+    detail::par_search_batch(queriesFirst, queriesLast, dst, [=, &func](queryIt chunkFirst, queryIt chunkLast, dstIt chunkDst) {
+        for (auto it = chunkFirst; it != chunkLast; it = std::next(it), chunkDst = std::next(chunkDst)) {
+
+            // Descend the tree (1-based node numbering) then go back up to the last node where we turned left
+            auto node = size_t{1};
+            while (node <= n)
+                node = 2 * node + (func(*(layoutFirst + (node - 1)), *it) ? 1 : 0);
+            while (node & 1)
+                node >>= 1;
+            node >>= 1;
+            *chunkDst = node == 0 ? layoutLast : layoutFirst + (node - 1);
+        }
+    }, chunkSize);
+    return std::next(dst, std::distance(queriesFirst, queriesLast));
+}
 
-    // Merge the two sorted parts
-    par_merge(first, srcMiddle, last);
+template <typename srcIt, typename queryIt, typename dstIt>
+auto par_eytzinger_lower_bound_many(srcIt layoutFirst, srcIt layoutLast, queryIt queriesFirst, queryIt queriesLast, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_eytzinger_lower_bound_many(layoutFirst, layoutLast, queriesFirst, queriesLast, dst, std::less<valueType>(), chunkSize);
+}
+
+// Parallel sort of a range of keys that applies the same permutation to a range of values
+
+template <typename keyIt, typename valueIt, typename functor>
+auto par_sort_by_key(keyIt keysFirst, keyIt keysLast, valueIt valuesFirst, functor func, size_t chunkSize) -> void {
+    using keyType = typename std::iterator_traits<keyIt>::value_type;
+    using valueType = typename std::iterator_traits<valueIt>::value_type;
+    using pairType = std::pair<keyType, valueType>;
+    const auto n = static_cast<size_t>(std::distance(keysFirst, keysLast));
+    auto pairs = std::vector<pairType>(n);
+
+    // Create a table of futures to gather the keys and values of each chunk asynchronously
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(n / chunkSize + 1);
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &pairs] {
+            for (auto i = startId; i < stopId; ++i)
+                pairs[i] = pairType(std::move(*(keysFirst + i)), std::move(*(valuesFirst + i)));
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    par_sort(pairs.begin(), pairs.end(), [&func](const pairType& a, const pairType& b) {
+        return func(a.first, b.first);
+    }, chunkSize);
+
+    // Scatter the sorted pairs back to the keys and values
+    futures.clear();
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &pairs] {
+            for (auto i = startId; i < stopId; ++i) {
+                *(keysFirst + i) = std::move(pairs[i].first);
+                *(valuesFirst + i) = std::move(pairs[i].second);
+            }
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+}
+
+template <typename keyIt, typename valueIt>
+auto par_sort_by_key(keyIt keysFirst, keyIt keysLast, valueIt valuesFirst, size_t chunkSize) -> void {
+    using keyType = typename std::iterator_traits<keyIt>::value_type;
+    par_sort_by_key(keysFirst, keysLast, valuesFirst, std::less<keyType>(), chunkSize);
+}
+
+// Parallel segmented reduction: for each run of consecutive equal keys, writes the key to keysDst and the
+// reduction of the corresponding values to valuesDst. Returns the ends of both destinations
+// Runs spanning several chunks are reduced per chunk, then the partial result of each chunk is combined
+// with the run started in a previous chunk
+
+template <typename keyIt, typename valueIt, typename keyDstIt, typename valueDstIt, typename predicate, typename functor>
+auto par_reduce_by_key(keyIt keysFirst, keyIt keysLast, valueIt valuesFirst, keyDstIt keysDst, valueDstIt valuesDst, predicate pred, functor func, size_t chunkSize) -> std::pair<keyDstIt, valueDstIt> {
+    using valueType = typename std::iterator_traits<valueIt>::value_type;
+    using carryType = std::pair<bool, valueType>;
+    const auto n = static_cast<size_t>(std::distance(keysFirst, keysLast));
+
+    // Flag the first key of each run and find where the runs starting in each chunk are written
+    auto heads = std::vector<char>{};
+    const auto headOffsets = detail::par_unique_flags(keysFirst, keysLast, pred, heads, chunkSize);
+
+    // Create a table of futures to reduce the runs of each chunk asynchronously
+    auto futures = std::vector<std::future<carryType>>{};
+    futures.reserve(headOffsets.size());
+    for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        const auto headOffset = headOffsets[chunkId];
+        auto future = std::async(std::launch::async, [=, &func, &heads] () -> carryType {
+            auto i = startId;
+
+            // Reduce the end of the run started in a previous chunk
+            auto carry = carryType{};
+            if (!heads[i]) {
+                carry.first = true;
+                carry.second = *(valuesFirst + i);
+                for (++i; i < stopId && !heads[i]; ++i)
+                    carry.second = func(carry.second, *(valuesFirst + i));
+            }
+
+            // Reduce the runs starting in this chunk
+            for (auto outputId = headOffset; i < stopId; ++outputId) {
+                *std::next(keysDst, outputId) = *(keysFirst + i);
+                valueType sum = *(valuesFirst + i);
+                for (++i; i < stopId && !heads[i]; ++i)
+                    sum = func(sum, *(valuesFirst + i));
+                *std::next(valuesDst, outputId) = sum;
+            }
+            return carry;
+        });
+        futures.emplace_back(std::move(future));
+    }
+
+    // Combine the partial results with the runs started in previous chunks, in order
+    for (size_t chunkId = 0; chunkId < futures.size(); ++chunkId) {
+        auto carry = futures[chunkId].get();
+        if (carry.first) {
+            auto runValue = std::next(valuesDst, headOffsets[chunkId] - 1);
+            *runValue = func(*runValue, carry.second);
+        }
+    }
+
+    return std::make_pair(std::next(keysDst, headOffsets.back()), std::next(valuesDst, headOffsets.back()));
+}
+
+template <typename keyIt, typename valueIt, typename keyDstIt, typename valueDstIt>
+auto par_reduce_by_key(keyIt keysFirst, keyIt keysLast, valueIt valuesFirst, keyDstIt keysDst, valueDstIt valuesDst, size_t chunkSize) -> std::pair<keyDstIt, valueDstIt> {
+    using keyType = typename std::iterator_traits<keyIt>::value_type;
+    using valueType = typename std::iterator_traits<valueIt>::value_type;
+    return par_reduce_by_key(keysFirst, keysLast, valuesFirst, keysDst, valuesDst, std::equal_to<keyType>(), std::plus<valueType>(), chunkSize);
+}
+
+namespace detail {
+
+// Mix the bits of a hash so that both its low bits (hash table slots) and its high bits (partitions)
+// are well distributed, even for identity hashes such as std::hash of integers
+
+inline auto par_mix_hash(size_t hash) -> std::uint64_t {
+    auto h = static_cast<std::uint64_t>(hash);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Number of bits needed to address one partition per chunk of a radix-partitioned hash algorithm
+
+inline auto par_partition_bits(size_t nchunks) -> unsigned {
+    auto bits = 0u;
+    while ((size_t{1} << bits) < nchunks && bits < 10)
+        ++bits;
+    return bits;
+}
+
+// Key, value and precomputed mixed hash of an aggregated group
+
+template <typename keyType, typename valueType>
+struct par_hashed_entry {
+    std::uint64_t hash;
+    keyType key;
+    valueType value;
+};
+
+// Open addressing hash table with linear probing that aggregates values by key
+
+template <typename keyType, typename valueType>
+class par_aggregation_table {
+public:
+    par_aggregation_table() : hashes(16), keys(16), values(16), used(16, 0), count(0) {}
+
+    template <typename functor>
+    auto insert(std::uint64_t hash, const keyType& key, const valueType& value, functor func) -> void {
+        if (2 * (count + 1) > used.size())
+            grow();
+        const auto mask = used.size() - 1;
+        for (auto slot = static_cast<size_t>(hash) & mask; ; slot = (slot + 1) & mask) {
+            if (!used[slot]) {
+                used[slot] = 1;
+                hashes[slot] = hash;
+                keys[slot] = key;
+                values[slot] = value;
+                ++count;
+                return;
+            }
+            if (hashes[slot] == hash && keys[slot] == key) {
+                values[slot] = func(values[slot], value);
+                return;
+            }
+        }
+    }
+
+    template <typename functor>
+    auto for_each(functor func) -> void {
+        for (size_t slot = 0; slot < used.size(); ++slot) {
+            if (used[slot])
+                func(hashes[slot], keys[slot], values[slot]);
+        }
+    }
+
+    auto size() const -> size_t {
+        return count;
+    }
+
+private:
+    auto grow() -> void {
+        const auto capacity = 2 * used.size();
+        const auto mask = capacity - 1;
+        auto newHashes = std::vector<std::uint64_t>(capacity);
+        auto newKeys = std::vector<keyType>(capacity);
+        auto newValues = std::vector<valueType>(capacity);
+        auto newUsed = std::vector<char>(capacity, 0);
+        for (size_t slot = 0; slot < used.size(); ++slot) {
+            if (!used[slot])
+                continue;
+            auto newSlot = static_cast<size_t>(hashes[slot]) & mask;
+            while (newUsed[newSlot])
+                newSlot = (newSlot + 1) & mask;
+            newUsed[newSlot] = 1;
+            newHashes[newSlot] = hashes[slot];
+            newKeys[newSlot] = std::move(keys[slot]);
+            newValues[newSlot] = std::move(values[slot]);
+        }
+        hashes.swap(newHashes);
+        keys.swap(newKeys);
+        values.swap(newValues);
+        used.swap(newUsed);
+    }
+
+    std::vector<std::uint64_t> hashes;
+    std::vector<keyType> keys;
+    std::vector<valueType> values;
+    std::vector<char> used;
+    size_t count;
+};
+
+} // namespace detail
+
+// Parallel hash-based group-by: returns one (key, aggregated value) pair per distinct key, in no particular
+// order. Each chunk pre-aggregates its elements in a private hash table and splits the groups into
+// partitions according to the high bits of their hash; each partition is then merged by its own task,
+// so no table is ever shared between tasks
+
+template <typename srcIt, typename keyFunctor, typename valueFunctor, typename functor>
+auto par_group_aggregate(srcIt first, srcIt last, keyFunctor keyFunc, valueFunctor valueFunc, functor func, size_t chunkSize)
+    -> std::vector<std::pair<typename std::decay<typename std::result_of<keyFunctor(typename std::iterator_traits<srcIt>::reference)>::type>::type,
+                             typename std::decay<typename std::result_of<valueFunctor(typename std::iterator_traits<srcIt>::reference)>::type>::type>> {
+    using keyType = typename std::decay<typename std::result_of<keyFunctor(typename std::iterator_traits<srcIt>::reference)>::type>::type;
+    using valueType = typename std::decay<typename std::result_of<valueFunctor(typename std::iterator_traits<srcIt>::reference)>::type>::type;
+    using entryType = detail::par_hashed_entry<keyType, valueType>;
+    using partitionsType = std::vector<std::vector<entryType>>;
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto bits = detail::par_partition_bits((n + chunkSize - 1) / chunkSize);
+    const auto npartitions = size_t{1} << bits;
+
+    // Create a table of futures to aggregate each chunk asynchronously
+    auto futures = std::vector<std::future<partitionsType>>{};
+    futures.reserve(n / chunkSize + 1);
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &keyFunc, &valueFunc, &func] () -> partitionsType {
+            auto table = detail::par_aggregation_table<keyType, valueType>{};
+            for (auto it = first + startId; it != first + stopId; it = std::next(it)) {
+                const keyType key = keyFunc(*it);
+                table.insert(detail::par_mix_hash(std::hash<keyType>()(key)), key, valueFunc(*it), func);
+            }
+            auto partitions = partitionsType(npartitions);
+            table.for_each([&](std::uint64_t hash, keyType& key, valueType& value) {
+                const auto partitionId = bits == 0 ? size_t{0} : static_cast<size_t>(hash >> (64 - bits));
+                partitions[partitionId].push_back(entryType{hash, std::move(key), std::move(value)});
+            });
+            return partitions;
+        });
+        futures.emplace_back(std::move(future));
+    }
+    auto chunkPartitions = std::vector<partitionsType>{};
+    chunkPartitions.reserve(futures.size());
+    for (auto& future : futures)
+        chunkPartitions.push_back(future.get());
+
+    // Create a table of futures to merge the groups of each partition asynchronously
+    using resultType = std::vector<std::pair<keyType, valueType>>;
+    auto mergeFutures = std::vector<std::future<resultType>>{};
+    mergeFutures.reserve(npartitions);
+    for (size_t partitionId = 0; partitionId < npartitions; ++partitionId) {
+        auto future = std::async(std::launch::async, [=, &chunkPartitions, &func] () -> resultType {
+            auto table = detail::par_aggregation_table<keyType, valueType>{};
+            for (auto& partitions : chunkPartitions) {
+                for (auto& entry : partitions[partitionId])
+                    table.insert(entry.hash, entry.key, entry.value, func);
+            }
+            auto groups = resultType{};
+            groups.reserve(table.size());
+            table.for_each([&](std::uint64_t, keyType& key, valueType& value) {
+                groups.emplace_back(std::move(key), std::move(value));
+            });
+            return groups;
+        });
+        mergeFutures.emplace_back(std::move(future));
+    }
+    auto partitionGroups = std::vector<resultType>{};
+    partitionGroups.reserve(npartitions);
+    auto groupOffsets = std::vector<size_t>{0};
+    for (auto& future : mergeFutures) {
+        partitionGroups.push_back(future.get());
+        groupOffsets.push_back(groupOffsets.back() + partitionGroups.back().size());
+    }
+
+    // Concatenate the groups of all the partitions
+    auto groups = resultType(groupOffsets.back());
+    auto copyFutures = std::vector<std::future<void>>{};
+    copyFutures.reserve(npartitions);
+    for (size_t partitionId = 0; partitionId < npartitions; ++partitionId) {
+        auto future = std::async(std::launch::async, [=, &partitionGroups, &groups] {
+            std::move(partitionGroups[partitionId].begin(), partitionGroups[partitionId].end(), groups.begin() + groupOffsets[partitionId]);
+        });
+        copyFutures.emplace_back(std::move(future));
+    }
+    for (auto& future : copyFutures)
+        future.wait();
+
+    return groups;
+}
+
+// Parallel hash join: for each pair of elements of the build and probe ranges having equal keys, writes the
+// result of func(buildElement, probeElement) to dst. Returns the end of the destination
+// The build range is radix-partitioned on the high bits of the key hashes so that the hash table of each
+// partition is small enough to stay in cache, and the tables are built in parallel. Each probe chunk writes
+// its matches to a private buffer and the buffers are then copied to the destination at their offsets
+
+template <typename buildIt, typename probeIt, typename dstIt, typename buildKeyFunctor, typename probeKeyFunctor, typename functor>
+auto par_hash_join(buildIt buildFirst, buildIt buildLast, probeIt probeFirst, probeIt probeLast, buildKeyFunctor buildKeyFunc,
+                   probeKeyFunctor probeKeyFunc, functor func, dstIt dst, size_t chunkSize) -> dstIt {
+    using keyType = typename std::decay<typename std::result_of<buildKeyFunctor(typename std::iterator_traits<buildIt>::reference)>::type>::type;
+    using resultType = typename std::decay<typename std::result_of<functor(typename std::iterator_traits<buildIt>::reference,
+                                                                            typename std::iterator_traits<probeIt>::reference)>::type>::type;
+    const auto maxPartitionSize = size_t{1} << 14;
+    const auto nbuild = static_cast<size_t>(std::distance(buildFirst, buildLast));
+    const auto nprobe = static_cast<size_t>(std::distance(probeFirst, probeLast));
+    const auto nchunks = (nbuild + chunkSize - 1) / chunkSize;
+    // The count matrices hold nchunks entries per partition: they are kept no larger than the build range
+    auto bits = detail::par_partition_bits(nchunks);
+    while ((nbuild >> bits) > maxPartitionSize && bits < 16 && (nchunks << (bits + 1)) <= nbuild)
+        ++bits;
+    const auto npartitions = size_t{1} << bits;
+    auto partitionOf = [bits](std::uint64_t hash) -> size_t {
+        return bits == 0 ? size_t{0} : static_cast<size_t>(hash >> (64 - bits));
+    };
+
+    // Hash the build keys and count the elements of each chunk falling in each partition
+    auto hashes = std::vector<std::uint64_t>(nbuild);
+    auto counts = std::vector<size_t>(nchunks * npartitions, 0);
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(nchunks);
+    for (size_t startId = 0, chunkId = 0; startId < nbuild; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, nbuild);
+        auto future = std::async(std::launch::async, [=, &buildKeyFunc, &hashes, &counts] {
+            for (auto i = startId; i < stopId; ++i) {
+                hashes[i] = detail::par_mix_hash(std::hash<keyType>()(buildKeyFunc(*(buildFirst + i))));
+                ++counts[chunkId * npartitions + partitionOf(hashes[i])];
+            }
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    // Compute where the elements of each chunk are written inside each partition
+    auto partitionOffsets = std::vector<size_t>(npartitions + 1, 0);
+    auto writeOffsets = std::vector<size_t>(nchunks * npartitions);
+    for (size_t partitionId = 0, offset = 0; partitionId < npartitions; ++partitionId) {
+        partitionOffsets[partitionId] = offset;
+        for (size_t chunkId = 0; chunkId < nchunks; ++chunkId) {
+            writeOffsets[chunkId * npartitions + partitionId] = offset;
+            offset += counts[chunkId * npartitions + partitionId];
+        }
+    }
+    partitionOffsets[npartitions] = nbuild;
+
+    // Scatter the indices of the build elements to their partition
+    auto rows = std::vector<size_t>(nbuild);
+    futures.clear();
+    for (size_t startId = 0, chunkId = 0; startId < nbuild; startId += chunkSize, ++chunkId) {
+        const auto stopId = std::min(startId + chunkSize, nbuild);
+        auto future = std::async(std::launch::async, [=, &hashes, &writeOffsets, &rows] {
+            auto offsets = std::vector<size_t>(writeOffsets.begin() + chunkId * npartitions, writeOffsets.begin() + (chunkId + 1) * npartitions);
+            for (auto i = startId; i < stopId; ++i)
+                rows[offsets[partitionOf(hashes[i])]++] = i;
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    // Build a chained hash table for each partition: buckets hold the position (plus one) of the first element
+    // of their chain inside the partition and next links the following elements. Each task builds the tables
+    // of a contiguous range of partitions holding about chunkSize build elements
+    auto buckets = std::vector<std::vector<size_t>>(npartitions);
+    auto next = std::vector<size_t>(nbuild);
+    futures.clear();
+    for (size_t firstPartition = 0; firstPartition < npartitions; ) {
+        auto lastPartition = firstPartition + 1;
+        while (lastPartition < npartitions && partitionOffsets[lastPartition + 1] - partitionOffsets[firstPartition] <= chunkSize)
+            ++lastPartition;
+        auto future = std::async(std::launch::async, [=, &hashes, &rows, &partitionOffsets, &buckets, &next] {
+            for (auto partitionId = firstPartition; partitionId < lastPartition; ++partitionId) {
+                const auto offset = partitionOffsets[partitionId];
+                const auto size = partitionOffsets[partitionId + 1] - offset;
+                auto nbuckets = size_t{1};
+                while (nbuckets < size)
+                    nbuckets *= 2;
+                auto& partitionBuckets = buckets[partitionId];
+                partitionBuckets.assign(nbuckets, 0);
+                for (size_t i = 0; i < size; ++i) {
+                    auto& head = partitionBuckets[static_cast<size_t>(hashes[rows[offset + i]]) & (nbuckets - 1)];
+                    next[offset + i] = head;
+                    head = i + 1;
+                }
+            }
+        });
+        futures.emplace_back(std::move(future));
+        firstPartition = lastPartition;
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    // Create a table of futures to probe each chunk asynchronously
+    auto probeFutures = std::vector<std::future<std::vector<resultType>>>{};
+    probeFutures.reserve(nprobe / chunkSize + 1);
+    for (size_t startId = 0; startId < nprobe; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, nprobe);
+        auto future = std::async(std::launch::async, [=, &buildKeyFunc, &probeKeyFunc, &func, &hashes, &rows, &partitionOffsets, &buckets, &next] () -> std::vector<resultType> {
+            auto results = std::vector<resultType>{};
+            for (auto it = probeFirst + startId; it != probeFirst + stopId; it = std::next(it)) {
+                const keyType key = probeKeyFunc(*it);
+                const auto hash = detail::par_mix_hash(std::hash<keyType>()(key));
+                const auto partitionId = partitionOf(hash);
+                const auto offset = partitionOffsets[partitionId];
+                const auto& partitionBuckets = buckets[partitionId];
+                for (auto i = partitionBuckets[static_cast<size_t>(hash) & (partitionBuckets.size() - 1)]; i != 0; i = next[offset + i - 1]) {
+                    const auto row = rows[offset + i - 1];
+                    if (hashes[row] == hash && buildKeyFunc(*(buildFirst + row)) == key)
+                        results.push_back(func(*(buildFirst + row), *it));
+                }
+            }
+            return results;
+        });
+        probeFutures.emplace_back(std::move(future));
+    }
+    auto results = std::vector<std::vector<resultType>>{};
+    results.reserve(probeFutures.size());
+    auto resultOffsets = std::vector<size_t>{0};
+    for (auto& future : probeFutures) {
+        results.push_back(future.get());
+        resultOffsets.push_back(resultOffsets.back() + results.back().size());
+    }
+
+    // Copy the matches of each probe chunk to the destination asynchronously
+    futures.clear();
+    for (size_t resultId = 0; resultId < results.size(); ++resultId) {
+        auto resultDst = std::next(dst, resultOffsets[resultId]);
+        auto future = std::async(std::launch::async, [=, &results] {
+            std::move(results[resultId].begin(), results[resultId].end(), resultDst);
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    return std::next(dst, resultOffsets.back());
+}
+
+// Parallel sort-merge join of two ranges sorted by key: for each pair of elements having equal keys, writes
+// the result of func(element1, element2) to dst. Returns the end of the destination
+// Splitter keys sampled from both ranges cut them into pairs of subranges; since a cut is always made at the
+// first element of a key, all the duplicates of a key are joined by the same task
+
+template <typename srcIt1, typename srcIt2, typename dstIt, typename keyFunctor1, typename keyFunctor2, typename functor>
+auto par_merge_join(srcIt1 first1, srcIt1 last1, srcIt2 first2, srcIt2 last2, keyFunctor1 keyFunc1, keyFunctor2 keyFunc2,
+                    functor func, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType1 = typename std::iterator_traits<srcIt1>::value_type;
+    using valueType2 = typename std::iterator_traits<srcIt2>::value_type;
+    using keyType = typename std::decay<typename std::result_of<keyFunctor1(typename std::iterator_traits<srcIt1>::reference)>::type>::type;
+    using resultType = typename std::decay<typename std::result_of<functor(typename std::iterator_traits<srcIt1>::reference,
+                                                                            typename std::iterator_traits<srcIt2>::reference)>::type>::type;
+    const auto n1 = static_cast<size_t>(std::distance(first1, last1));
+    const auto n2 = static_cast<size_t>(std::distance(first2, last2));
+
+    // Sample the splitter keys at regular intervals of both ranges
+    auto splitters = std::vector<keyType>{};
+    for (auto i = chunkSize; i < n1; i += chunkSize)
+        splitters.push_back(keyFunc1(*(first1 + i)));
+    for (auto i = chunkSize; i < n2; i += chunkSize)
+        splitters.push_back(keyFunc2(*(first2 + i)));
+    std::sort(splitters.begin(), splitters.end());
+    splitters.erase(std::unique(splitters.begin(), splitters.end()), splitters.end());
+
+    // Cut both ranges at the first element of each splitter key
+    auto splits = std::vector<std::pair<size_t, size_t>>{std::make_pair(size_t{0}, size_t{0})};
+    for (const auto& splitter : splitters) {
+        const auto split1 = std::lower_bound(first1, last1, splitter, [&keyFunc1](const valueType1& a, const keyType& key) {
+            return keyFunc1(a) < key;
+        });
+        const auto split2 = std::lower_bound(first2, last2, splitter, [&keyFunc2](const valueType2& a, const keyType& key) {
+            return keyFunc2(a) < key;
+        });
+        splits.push_back(std::make_pair(static_cast<size_t>(split1 - first1), static_cast<size_t>(split2 - first2)));
+    }
+    splits.push_back(std::make_pair(n1, n2));
+
+    // Create a table of futures to join each pair of subranges asynchronously
+    auto futures = std::vector<std::future<std::vector<resultType>>>{};
+    futures.reserve(splits.size());
+    for (size_t splitId = 0; splitId + 1 < splits.size(); ++splitId) {
+        const auto start = splits[splitId], stop = splits[splitId + 1];
+        auto future = std::async(std::launch::async, [=, &keyFunc1, &keyFunc2, &func] () -> std::vector<resultType> {
+            auto results = std::vector<resultType>{};
+            auto i = start.first, j = start.second;
+            while (i < stop.first && j < stop.second) {
+                const keyType key1 = keyFunc1(*(first1 + i));
+                const keyType key2 = keyFunc2(*(first2 + j));
+                if (key1 < key2) {
+                    ++i;
+                    continue;
+                }
+                if (key2 < key1) {
+                    ++j;
+                    continue;
+                }
+
+                // Join the runs of equal keys of both ranges
+                auto runStop1 = i + 1, runStop2 = j + 1;
+                while (runStop1 < stop.first && !(key1 < keyFunc1(*(first1 + runStop1))))
+                    ++runStop1;
+                while (runStop2 < stop.second && !(key2 < keyFunc2(*(first2 + runStop2))))
+                    ++runStop2;
+                for (auto id1 = i; id1 < runStop1; ++id1) {
+                    for (auto id2 = j; id2 < runStop2; ++id2)
+                        results.push_back(func(*(first1 + id1), *(first2 + id2)));
+                }
+                i = runStop1;
+                j = runStop2;
+            }
+            return results;
+        });
+        futures.emplace_back(std::move(future));
+    }
+    auto results = std::vector<std::vector<resultType>>{};
+    results.reserve(futures.size());
+    auto resultOffsets = std::vector<size_t>{0};
+    for (auto& future : futures) {
+        results.push_back(future.get());
+        resultOffsets.push_back(resultOffsets.back() + results.back().size());
+    }
+
+    // Copy the matches of each pair of subranges to the destination asynchronously
+    auto copyFutures = std::vector<std::future<void>>{};
+    copyFutures.reserve(results.size());
+    for (size_t resultId = 0; resultId < results.size(); ++resultId) {
+        auto resultDst = std::next(dst, resultOffsets[resultId]);
+        auto future = std::async(std::launch::async, [=, &results] {
+            std::move(results[resultId].begin(), results[resultId].end(), resultDst);
+        });
+        copyFutures.emplace_back(std::move(future));
+    }
+    for (auto& future : copyFutures)
+        future.wait();
+
+    return std::next(dst, resultOffsets.back());
+}
+
+// Parallel argsort: returns the permutation of indices that sorts the range, leaving the range untouched.
+// Apply it to any number of columns with par_gather. Equivalent elements keep their relative order
+// Indices are sorted by comparing the elements they point to, so large elements are never moved
+
+template <typename srcIt, typename functor>
+auto par_argsort(srcIt first, srcIt last, functor func, size_t chunkSize) -> std::vector<size_t> {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    auto indices = std::vector<size_t>(n);
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(n / chunkSize + 1);
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &indices] {
+            std::iota(indices.begin() + startId, indices.begin() + stopId, startId);
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    par_sort(indices.begin(), indices.end(), [first, &func](size_t a, size_t b) {
+        const auto& valueA = *(first + a);
+        const auto& valueB = *(first + b);
+        return func(valueA, valueB) || (!func(valueB, valueA) && a < b);
+    }, chunkSize);
+    return indices;
+}
+
+namespace detail {
+
+// Unsigned integer type with the same size as a radix sorted key
+
+template <size_t size> struct par_radix_unsigned;
+template <> struct par_radix_unsigned<1> { using type = std::uint8_t; };
+template <> struct par_radix_unsigned<2> { using type = std::uint16_t; };
+template <> struct par_radix_unsigned<4> { using type = std::uint32_t; };
+template <> struct par_radix_unsigned<8> { using type = std::uint64_t; };
+
+// Map an arithmetic value to an unsigned integer with the same ordering
+
+template <typename valueType>
+auto par_radix_key(const valueType& value) -> typename par_radix_unsigned<sizeof(valueType)>::type {
+    using unsignedType = typename par_radix_unsigned<sizeof(valueType)>::type;
+    const auto signBit = static_cast<unsignedType>(unsignedType(1) << (8 * sizeof(valueType) - 1));
+    auto bits = unsignedType{};
+    std::memcpy(&bits, &value, sizeof(valueType));
+    if (std::is_floating_point<valueType>::value)
+        return (bits & signBit) ? static_cast<unsignedType>(~bits) : static_cast<unsignedType>(bits | signBit);
+    if (std::is_signed<valueType>::value)
+        return static_cast<unsignedType>(bits ^ signBit);
+    return bits;
+}
+
+// Argsort of arithmetic values with a parallel LSD radix sort of (key, index) pairs, one byte per pass.
+// Each pass builds a histogram per chunk then every chunk scatters its pairs to their place, which keeps
+// the sort stable. Passes on a byte shared by all the keys are skipped
+
+template <typename srcIt>
+auto par_argsort_radix(srcIt first, srcIt last, size_t chunkSize) -> std::vector<size_t> {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    using keyType = typename par_radix_unsigned<sizeof(valueType)>::type;
+    using pairType = std::pair<keyType, size_t>;
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto nchunks = (n + chunkSize - 1) / chunkSize;
+    const auto radix = size_t{256};
+    auto pairs = std::vector<pairType>(n), buffer = std::vector<pairType>(n);
+    auto counts = std::vector<size_t>(nchunks * radix);
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(nchunks);
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &pairs] {
+            for (auto i = startId; i < stopId; ++i)
+                pairs[i] = pairType(par_radix_key(static_cast<valueType>(*(first + i))), i);
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    for (size_t shift = 0; shift < 8 * sizeof(keyType); shift += 8) {
+
+        // Count the digits of each chunk
+        std::fill(counts.begin(), counts.end(), size_t{0});
+        futures.clear();
+        for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+            const auto stopId = std::min(startId + chunkSize, n);
+            auto future = std::async(std::launch::async, [=, &pairs, &counts] {
+                for (auto i = startId; i < stopId; ++i)
+                    ++counts[chunkId * radix + ((pairs[i].first >> shift) & 0xff)];
+            });
+            futures.emplace_back(std::move(future));
+        }
+        for (auto& future : futures)
+            future.wait();
+
+        // Turn the counts into the write offsets of each chunk, skipping the pass if all the digits are equal
+        auto sameDigit = false;
+        for (size_t digit = 0, offset = 0; digit < radix; ++digit) {
+            auto digitCount = size_t{0};
+            for (size_t chunkId = 0; chunkId < nchunks; ++chunkId) {
+                const auto count = counts[chunkId * radix + digit];
+                counts[chunkId * radix + digit] = offset;
+                offset += count;
+                digitCount += count;
+            }
+            sameDigit = sameDigit || digitCount == n;
+        }
+        if (sameDigit)
+            continue;
+
+        // Scatter the pairs of each chunk asynchronously
+        futures.clear();
+        for (size_t startId = 0, chunkId = 0; startId < n; startId += chunkSize, ++chunkId) {
+            const auto stopId = std::min(startId + chunkSize, n);
+            auto future = std::async(std::launch::async, [=, &pairs, &buffer, &counts] {
+                auto offsets = counts.begin() + chunkId * radix;
+                for (auto i = startId; i < stopId; ++i)
+                    buffer[offsets[(pairs[i].first >> shift) & 0xff]++] = pairs[i];
+            });
+            futures.emplace_back(std::move(future));
+        }
+        for (auto& future : futures)
+            future.wait();
+        pairs.swap(buffer);
+    }
+
+    auto indices = std::vector<size_t>(n);
+    par_transform(pairs.begin(), pairs.end(), indices.begin(), [](const pairType& a) {
+        return a.second;
+    }, chunkSize);
+    return indices;
+}
+
+template <typename srcIt>
+auto par_argsort_impl(srcIt first, srcIt last, size_t chunkSize, std::true_type) -> std::vector<size_t> {
+    return par_argsort_radix(first, last, chunkSize);
+}
+
+template <typename srcIt>
+auto par_argsort_impl(srcIt first, srcIt last, size_t chunkSize, std::false_type) -> std::vector<size_t> {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_argsort(first, last, std::less<valueType>(), chunkSize);
+}
+
+} // namespace detail
+
+// Arithmetic values are radix sorted, other types are compared with operator<
+
+template <typename srcIt>
+auto par_argsort(srcIt first, srcIt last, size_t chunkSize) -> std::vector<size_t> {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    using isRadixSortable = std::integral_constant<bool, std::is_arithmetic<valueType>::value && sizeof(valueType) <= 8>;
+    return detail::par_argsort_impl(first, last, chunkSize, isRadixSortable());
+}
+
+namespace detail {
+
+// Early exit search shared by the algorithms looking for the first element satisfying a condition:
+// func(startId, stopId) returns the first matching index in [startId, stopId), or stopId if there is none.
+// Chunks are scanned block by block and a task stops as soon as a match has been found before its current
+// block (or anywhere if anyMatch is set). Returns the first matching index, or n if there is none
+
+const size_t par_cancellation_block_size = 16384;
+
+template <typename functor>
+auto par_find_first_index(size_t n, functor func, bool anyMatch, size_t chunkSize) -> size_t {
+    std::atomic<size_t> found(n);
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(n / chunkSize + 1);
+
+    // Create a table of futures to search each chunk asynchronously
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=, &func, &found] {
+            for (auto blockStart = startId; blockStart < stopId; blockStart += par_cancellation_block_size) {
+                const auto foundId = found.load(std::memory_order_relaxed);
+                if (foundId <= blockStart || (anyMatch && foundId != n))
+                    return;
+                const auto blockStop = std::min(blockStart + par_cancellation_block_size, stopId);
+                const auto matchId = func(blockStart, blockStop);
+                if (matchId != blockStop) {
+                    auto currentId = found.load();
+                    while (matchId < currentId && !found.compare_exchange_weak(currentId, matchId)) {}
+                    return;
+                }
+            }
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.wait();
+
+    return found.load();
+}
+
+// Equality functor accepting operands of different types
+
+struct par_equal_to {
+    template <typename valueType1, typename valueType2>
+    auto operator()(const valueType1& a, const valueType2& b) const -> bool {
+        return a == b;
+    }
+};
+
+} // namespace detail
+
+// Parallel version of std::mismatch
+
+template <typename srcIt, typename dstIt, typename functor>
+auto par_mismatch(srcIt first, srcIt last, dstIt dst, functor func, size_t chunkSize) -> std::pair<srcIt, dstIt> {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto mismatchId = detail::par_find_first_index(n, [=, &func](size_t startId, size_t stopId) -> size_t {
+        const auto mismatch = std::mismatch(first + startId, first + stopId, std::next(dst, startId), func);
+        return static_cast<size_t>(std::distance(first, mismatch.first));
+    }, false, chunkSize);
+    return std::make_pair(std::next(first, mismatchId), std::next(dst, mismatchId));
+}
+
+template <typename srcIt, typename dstIt>
+auto par_mismatch(srcIt first, srcIt last, dstIt dst, size_t chunkSize) -> std::pair<srcIt, dstIt> {
+    return par_mismatch(first, last, dst, detail::par_equal_to(), chunkSize);
 }
 
 // Parallel version of equal
+// All the tasks stop as soon as one of them finds a difference
 
 template <typename srcIt, typename dstIt, typename functor>
 auto par_equal(srcIt first, srcIt last, dstIt dst, functor func, size_t chunkSize) -> bool {
-    using valueType=typename std::iterator_traits<srcIt>::value_type;
     const auto n = static_cast<size_t>(std::distance(first, last));
     if (n <= chunkSize) {
         return std::equal(first, last, dst, func);
     }
-    const auto srcMiddle = std::next(first, n / 2);
+    const auto mismatchId = detail::par_find_first_index(n, [=, &func](size_t startId, size_t stopId) -> size_t {
+        const auto mismatch = std::mismatch(first + startId, first + stopId, std::next(dst, startId), func);
+        return static_cast<size_t>(std::distance(first, mismatch.first));
+    }, true, chunkSize);
+    return mismatchId == n;
+}
 
-    // Create a new task to treat the first part
-    auto future = std::async(std::launch::async, [=,&func] () -> valueType {
-        return par_equal(first, srcMiddle, dst, func, chunkSize);
-    });
+template <typename srcIt, typename dstIt>
+auto par_equal(srcIt first, srcIt last, dstIt dst, size_t chunkSize) -> bool {
+    return par_equal(first, last, dst, detail::par_equal_to(), chunkSize);
+}
 
-    // Treat the second part recursively
-    const auto dstMiddle = std::next(dst, n / 2);
-    auto equal1=par_equal(srcMiddle, last, dstMiddle, func, chunkSize);
+namespace detail {
+
+// Boyer-Moore-Horspool search of a pattern of m bytes, using the shift table built by par_horspool_shifts
 
-    auto equal2=future.get();
-    return equal1 && equal2;
+template <typename patternIt>
+auto par_horspool_shifts(patternIt patternFirst, size_t m) -> std::array<size_t, 256> {
+    auto shifts = std::array<size_t, 256>{};
+    shifts.fill(m);
+    for (size_t i = 0; i + 1 < m; ++i)
+        shifts[static_cast<unsigned char>(*(patternFirst + i))] = m - 1 - i;
+    return shifts;
 }
 
-template <typename srcIt, typename dstIt>
-auto par_equal(srcIt first, srcIt last, dstIt dst, size_t chunkSize) -> bool {
-    using valueType=typename std::iterator_traits<srcIt>::value_type;
+template <typename srcIt, typename patternIt>
+auto par_horspool_search(srcIt first, srcIt last, patternIt patternFirst, size_t m, const std::array<size_t, 256>& shifts) -> srcIt {
     const auto n = static_cast<size_t>(std::distance(first, last));
-    if (n <= chunkSize) {
-        return std::equal(first, last, dst);
+    const auto lastByte = static_cast<unsigned char>(*(patternFirst + (m - 1)));
+    for (size_t position = 0; position + m <= n; ) {
+        const auto byte = static_cast<unsigned char>(*(first + (position + m - 1)));
+        if (byte == lastByte && std::equal(patternFirst, patternFirst + (m - 1), first + position))
+            return first + position;
+        position += shifts[byte];
     }
-    const auto srcMiddle = std::next(first, n / 2);
+    return last;
+}
 
-    // Create a new task to treat the first part
-    auto future = std::async(std::launch::async, [=] () -> valueType {
-        return par_equal(first, srcMiddle, dst, chunkSize);
-    });
+} // namespace detail
 
-    // Treat the second part recursively
-    const auto dstMiddle = std::next(dst, n / 2);
-    auto equal1=par_equal(srcMiddle, last, dstMiddle, chunkSize);
+// Parallel version of std::search
+// Each task looks for the occurrences starting in its own chunk, reading up to m - 1 elements past the
+// end of the chunk. Tasks stop as soon as an occurrence has been found before their current block
+
+template <typename srcIt, typename patternIt, typename functor>
+auto par_search(srcIt first, srcIt last, patternIt patternFirst, patternIt patternLast, functor func, size_t chunkSize) -> srcIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto m = static_cast<size_t>(std::distance(patternFirst, patternLast));
+    if (m == 0) {
+        return first;
+    }
+    if (n < m) {
+        return last;
+    }
+    const auto foundId = detail::par_find_first_index(n - m + 1, [=, &func](size_t startId, size_t stopId) -> size_t {
+        const auto windowLast = first + (stopId + m - 1);
+        const auto found = std::search(first + startId, windowLast, patternFirst, patternLast, func);
+        return found == windowLast ? stopId : static_cast<size_t>(found - first);
+    }, false, chunkSize);
+    return foundId == n - m + 1 ? last : std::next(first, foundId);
+}
+
+namespace detail {
+
+template <typename srcIt, typename patternIt>
+auto par_search_impl(srcIt first, srcIt last, patternIt patternFirst, patternIt patternLast, size_t chunkSize, std::false_type) -> srcIt {
+    return par_search(first, last, patternFirst, patternLast, par_equal_to(), chunkSize);
+}
+
+// Byte ranges are searched with Boyer-Moore-Horspool, whose shift table is built once for all the tasks
+
+template <typename srcIt, typename patternIt>
+auto par_search_impl(srcIt first, srcIt last, patternIt patternFirst, patternIt patternLast, size_t chunkSize, std::true_type) -> srcIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto m = static_cast<size_t>(std::distance(patternFirst, patternLast));
+    if (m < 4 || n < m) {
+        return par_search(first, last, patternFirst, patternLast, par_equal_to(), chunkSize);
+    }
+    const auto shifts = par_horspool_shifts(patternFirst, m);
+    const auto foundId = par_find_first_index(n - m + 1, [=, &shifts](size_t startId, size_t stopId) -> size_t {
+        const auto windowLast = first + (stopId + m - 1);
+        const auto found = par_horspool_search(first + startId, windowLast, patternFirst, m, shifts);
+        return found == windowLast ? stopId : static_cast<size_t>(found - first);
+    }, false, chunkSize);
+    return foundId == n - m + 1 ? last : std::next(first, foundId);
+}
+
+} // namespace detail
+
+template <typename srcIt, typename patternIt>
+auto par_search(srcIt first, srcIt last, patternIt patternFirst, patternIt patternLast, size_t chunkSize) -> srcIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    using patternType = typename std::iterator_traits<patternIt>::value_type;
+    using isByteSearch = std::integral_constant<bool, detail::par_is_byte_type<valueType>::value && detail::par_is_byte_type<patternType>::value>;
+    return detail::par_search_impl(first, last, patternFirst, patternLast, chunkSize, isByteSearch());
+}
+
+// Parallel version of std::find_first_of
+
+template <typename srcIt, typename patternIt, typename functor>
+auto par_find_first_of(srcIt first, srcIt last, patternIt patternFirst, patternIt patternLast, functor func, size_t chunkSize) -> srcIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto foundId = detail::par_find_first_index(n, [=, &func](size_t startId, size_t stopId) -> size_t {
+        return static_cast<size_t>(std::find_first_of(first + startId, first + stopId, patternFirst, patternLast, func) - first);
+    }, false, chunkSize);
+    return std::next(first, foundId);
+}
+
+namespace detail {
+
+template <typename srcIt, typename patternIt>
+auto par_find_first_of_impl(srcIt first, srcIt last, patternIt patternFirst, patternIt patternLast, size_t chunkSize, std::false_type) -> srcIt {
+    return par_find_first_of(first, last, patternFirst, patternLast, par_equal_to(), chunkSize);
+}
+
+// Byte ranges are tested against a 256-bit bitmap of the searched bytes
+
+template <typename srcIt, typename patternIt>
+auto par_find_first_of_impl(srcIt first, srcIt last, patternIt patternFirst, patternIt patternLast, size_t chunkSize, std::true_type) -> srcIt {
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    auto bitmap = std::array<std::uint64_t, 4>{};
+    for (auto it = patternFirst; it != patternLast; it = std::next(it)) {
+        const auto byte = static_cast<unsigned char>(*it);
+        bitmap[byte >> 6] |= std::uint64_t{1} << (byte & 63);
+    }
+    const auto foundId = par_find_first_index(n, [=](size_t startId, size_t stopId) -> size_t {
+        for (auto i = startId; i < stopId; ++i) {
+            const auto byte = static_cast<unsigned char>(*(first + i));
+            if (bitmap[byte >> 6] & (std::uint64_t{1} << (byte & 63)))
+                return i;
+        }
+        return stopId;
+    }, false, chunkSize);
+    return std::next(first, foundId);
+}
 
-    auto equal2=future.get();
-    return equal1 && equal2;
+} // namespace detail
+
+template <typename srcIt, typename patternIt>
+auto par_find_first_of(srcIt first, srcIt last, patternIt patternFirst, patternIt patternLast, size_t chunkSize) -> srcIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    using patternType = typename std::iterator_traits<patternIt>::value_type;
+    using isByteSearch = std::integral_constant<bool, detail::par_is_byte_type<valueType>::value && detail::par_is_byte_type<patternType>::value>;
+    return detail::par_find_first_of_impl(first, last, patternFirst, patternLast, chunkSize, isByteSearch());
 }
 
 // Parallel version of all_of
@@ -677,4 +3087,74 @@ auto par_min_element(srcIt first, srcIt last, functor func, size_t chunkSize) ->
     return func(*min2,*min1)?min2:min1;
 }
 
+namespace detail {
+
+// The k best elements of a range in descending order: each chunk keeps them in a bounded heap
+
+template <typename srcIt, typename functor>
+auto par_top_k_impl(srcIt first, srcIt last, size_t k, functor func, size_t chunkSize) -> std::vector<typename std::iterator_traits<srcIt>::value_type> {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    auto worse = [&func](const valueType& a, const valueType& b) {
+        return func(b, a);
+    };
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    if (n <= chunkSize) {
+
+        // Keep the k best elements in a heap whose front is the worst of them
+        auto heap = std::vector<valueType>{};
+        heap.reserve(std::min(n, k));
+        for (auto it = first; it != last; it = std::next(it)) {
+            if (heap.size() < k) {
+                heap.push_back(*it);
+                std::push_heap(heap.begin(), heap.end(), worse);
+            }
+            else if (func(heap.front(), *it)) {
+                std::pop_heap(heap.begin(), heap.end(), worse);
+                heap.back() = *it;
+                std::push_heap(heap.begin(), heap.end(), worse);
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), worse);
+        return heap;
+    }
+    const auto srcMiddle = std::next(first, n / 2);
+
+    // Create a new task to treat the first part
+    auto future = std::async(std::launch::async, [=, &func] () -> std::vector<valueType> {
+        return par_top_k_impl(first, srcMiddle, k, func, chunkSize);
+    });
+
+    // Treat the second part recursively
+    auto best1 = par_top_k_impl(srcMiddle, last, k, func, chunkSize);
+    auto best2 = future.get();
+
+    // Keep the k best elements of both parts
+    auto best = std::vector<valueType>(best1.size() + best2.size());
+    std::merge(best2.begin(), best2.end(), best1.begin(), best1.end(), best.begin(), worse);
+    best.resize(std::min(best.size(), k));
+    return best;
+}
+
+} // namespace detail
+
+// Parallel top-k selection: copies the k greatest elements in descending order without modifying the container
+// Each chunk keeps its best elements in a bounded heap and the partial results are merged pairwise
+
+template <typename srcIt, typename dstIt, typename functor>
+auto par_top_k(srcIt first, srcIt last, size_t k, dstIt dst, functor func, size_t chunkSize) -> dstIt {
+    if (k == 0) {
+        return dst;
+    }
+    auto best = detail::par_top_k_impl(first, last, k, func, chunkSize);
+    return std::copy(best.begin(), best.end(), dst);
+}
+
+template <typename srcIt, typename dstIt>
+auto par_top_k(srcIt first, srcIt last, size_t k, dstIt dst, size_t chunkSize) -> dstIt {
+    using valueType = typename std::iterator_traits<srcIt>::value_type;
+    return par_top_k(first, last, k, dst, std::less<valueType>(), chunkSize);
+}
+
 }
+
+#endif // ABPARALLEL_H
@@ -0,0 +1,1173 @@
+/////////////////////////////////////////////////////////////////////////////
+/// Name:        parallel_io.h
+/// Purpose:     File input/output for the parallel algorithms of ABParallel.
+/// Author:      Ahmed Hamdi Boujelben <ahmed.hamdi.boujelben@gmail.com>
+/// Created:     2018
+/// Copyright:   (c) 2018 Ahmed Hamdi Boujelben
+/// Licence:     Attribution-NonCommercial 4.0 International
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef ABPARALLEL_IO_H
+#define ABPARALLEL_IO_H
+
+#include "parallel.h"
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(ABPARALLEL_USE_IO_URING) && defined(__linux__) && defined(__has_include)
+#if __has_include(<liburing.h>)
+#define ABPARALLEL_IO_URING
+#include <liburing.h>
+#endif
+#endif
+
+#if defined(ABPARALLEL_USE_LZ4) && defined(__has_include)
+#if __has_include(<lz4.h>)
+#define ABPARALLEL_LZ4
+#include <lz4.h>
+#endif
+#endif
+
+#if defined(ABPARALLEL_USE_ZSTD) && defined(__has_include)
+#if __has_include(<zstd.h>)
+#define ABPARALLEL_ZSTD
+#include <zstd.h>
+#endif
+#endif
+
+namespace ABParallel {
+
+namespace detail {
+
+// Throws the last system error of the calling thread
+
+inline auto par_throw_system_error(const std::string& what) -> void {
+#if defined(_WIN32)
+    throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+#else
+    throw std::system_error(errno, std::generic_category(), what);
+#endif
+}
+
+} // namespace detail
+
+// Access pattern hints given to the operating system for a mapped range
+
+enum class par_access_hint {
+    normal,
+    sequential,
+    random,
+    will_need,
+    dont_need
+};
+
+// Memory-mapped file exposed as a contiguous range of chars, so that the par_* algorithms run directly
+// over the file data without copying it (begin() and end() are pointers and therefore also benefit from the
+// byte kernels of par_count and par_find). The character type sets the access: par_mapped_file maps an
+// existing file read-only and only hands out const char pointers, while par_writable_mapped_file maps an
+// existing file read-write or creates it with a given size, and its modifications are written back to the
+// file. Errors are reported with std::system_error
+
+template <typename charType>
+class par_basic_mapped_file {
+public:
+    explicit par_basic_mapped_file(const std::string& path) : par_basic_mapped_file() {
+        open(path, false, 0);
+    }
+
+    // Create (or truncate) the file at path with the given size and map it read-write
+
+    par_basic_mapped_file(const std::string& path, size_t size) : par_basic_mapped_file() {
+        static_assert(writable(), "par_mapped_file: only a writable mapping can create a file");
+        open(path, true, size);
+    }
+
+    par_basic_mapped_file(par_basic_mapped_file&& other) noexcept : par_basic_mapped_file() {
+        swap(other);
+    }
+
+    auto operator=(par_basic_mapped_file&& other) noexcept -> par_basic_mapped_file& {
+        if (this != &other) {
+            close();
+            swap(other);
+        }
+        return *this;
+    }
+
+    par_basic_mapped_file(const par_basic_mapped_file&) = delete;
+    auto operator=(const par_basic_mapped_file&) -> par_basic_mapped_file& = delete;
+
+    ~par_basic_mapped_file() {
+        close();
+    }
+
+    auto data() -> charType* { return address; }
+    auto data() const -> const char* { return address; }
+    auto begin() -> charType* { return address; }
+    auto begin() const -> const char* { return address; }
+    auto end() -> charType* { return address + length; }
+    auto end() const -> const char* { return address + length; }
+    auto size() const -> size_t { return length; }
+    auto empty() const -> bool { return length == 0; }
+    static constexpr auto writable() -> bool { return !std::is_const<charType>::value; }
+
+    // Give an access pattern hint for the bytes [offset, offset + count) of the mapping. Hints are only
+    // advice: they are ignored where the operating system does not support them
+
+    auto advise(par_access_hint hint, size_t offset, size_t count) const -> void {
+        if (offset >= length || count == 0)
+            return;
+        count = std::min(count, length - offset);
+#if defined(_WIN32)
+        (void)hint;
+#else
+        const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const auto pageStart = offset / page * page;
+        auto advice = MADV_NORMAL;
+        switch (hint) {
+        case par_access_hint::sequential: advice = MADV_SEQUENTIAL; break;
+        case par_access_hint::random: advice = MADV_RANDOM; break;
+        case par_access_hint::will_need: advice = MADV_WILLNEED; break;
+        case par_access_hint::dont_need: advice = MADV_DONTNEED; break;
+        default: break;
+        }
+        madvise(address + pageStart, offset + count - pageStart, advice);
+#endif
+    }
+
+    auto advise(par_access_hint hint) const -> void {
+        advise(hint, 0, length);
+    }
+
+    // Write the modifications of a read-write mapping back to the file
+
+    auto flush() -> void {
+        static_assert(writable(), "par_mapped_file: a read-only mapping has nothing to flush");
+        if (length == 0)
+            return;
+#if defined(_WIN32)
+        if (!FlushViewOfFile(address, 0) || !FlushFileBuffers(fileHandle))
+            detail::par_throw_system_error("par_mapped_file: cannot flush " + filePath);
+#else
+        if (msync(address, length, MS_SYNC) != 0)
+            detail::par_throw_system_error("par_mapped_file: cannot flush " + filePath);
+#endif
+    }
+
+private:
+    par_basic_mapped_file() : address(nullptr), length(0),
+#if defined(_WIN32)
+        fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+#else
+        fileDescriptor(-1)
+#endif
+    {}
+
+    auto open(const std::string& path, bool create, size_t size) -> void {
+        filePath = path;
+#if defined(_WIN32)
+        fileHandle = CreateFileA(path.c_str(), writable() ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                 FILE_SHARE_READ, nullptr, create ? CREATE_ALWAYS : OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            detail::par_throw_system_error("par_mapped_file: cannot open " + path);
+        auto fileSize = LARGE_INTEGER{};
+        if (create) {
+            fileSize.QuadPart = static_cast<LONGLONG>(size);
+        }
+        else if (!GetFileSizeEx(fileHandle, &fileSize)) {
+            detail::par_throw_system_error("par_mapped_file: cannot read the size of " + path);
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+        if (length == 0)
+            return;
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, writable() ? PAGE_READWRITE : PAGE_READONLY,
+                                           static_cast<DWORD>(fileSize.QuadPart >> 32),
+                                           static_cast<DWORD>(fileSize.QuadPart & 0xFFFFFFFF), nullptr);
+        if (mappingHandle == nullptr) {
+            detail::par_throw_system_error("par_mapped_file: cannot map " + path);
+        }
+        address = static_cast<char*>(MapViewOfFile(mappingHandle, writable() ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+        if (address == nullptr) {
+            detail::par_throw_system_error("par_mapped_file: cannot map " + path);
+        }
+#else
+        auto flags = writable() ? O_RDWR : O_RDONLY;
+        if (create)
+            flags |= O_CREAT | O_TRUNC;
+        fileDescriptor = ::open(path.c_str(), flags, 0644);
+        if (fileDescriptor < 0)
+            detail::par_throw_system_error("par_mapped_file: cannot open " + path);
+        if (create) {
+            if (ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0) {
+                detail::par_throw_system_error("par_mapped_file: cannot resize " + path);
+            }
+            length = size;
+        }
+        else {
+            struct stat status;
+            if (fstat(fileDescriptor, &status) != 0) {
+                detail::par_throw_system_error("par_mapped_file: cannot read the size of " + path);
+            }
+            length = static_cast<size_t>(status.st_size);
+        }
+        if (length == 0)
+            return;
+        auto mapping = mmap(nullptr, length, writable() ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fileDescriptor, 0);
+        if (mapping == MAP_FAILED) {
+            length = 0;
+            detail::par_throw_system_error("par_mapped_file: cannot map " + path);
+        }
+        address = static_cast<char*>(mapping);
+#endif
+    }
+
+    auto close() -> void {
+#if defined(_WIN32)
+        if (address != nullptr)
+            UnmapViewOfFile(address);
+        if (mappingHandle != nullptr)
+            CloseHandle(mappingHandle);
+        if (fileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+        mappingHandle = nullptr;
+#else
+        if (address != nullptr)
+            munmap(address, length);
+        if (fileDescriptor >= 0)
+            ::close(fileDescriptor);
+        fileDescriptor = -1;
+#endif
+        address = nullptr;
+        length = 0;
+    }
+
+    auto swap(par_basic_mapped_file& other) noexcept -> void {
+        std::swap(address, other.address);
+        std::swap(length, other.length);
+        std::swap(filePath, other.filePath);
+#if defined(_WIN32)
+        std::swap(fileHandle, other.fileHandle);
+        std::swap(mappingHandle, other.mappingHandle);
+#else
+        std::swap(fileDescriptor, other.fileDescriptor);
+#endif
+    }
+
+    char* address;
+    size_t length;
+    std::string filePath;
+#if defined(_WIN32)
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+};
+
+using par_mapped_file = par_basic_mapped_file<const char>;
+using par_writable_mapped_file = par_basic_mapped_file<char>;
+
+// Sliding read-ahead window over a mapped file: requests the pages of the chunk starting at offset and of the
+// lookahead chunks following it. Called by the processing loop before each chunk, it keeps only a few chunks
+// ahead of the consumer in flight, so that on files larger than memory the pages read ahead are not evicted
+// before they are processed. The algorithms do not prefetch by themselves: the caller drives this window from
+// its own loop over the mapping
+
+template <typename charType>
+auto par_prefetch_chunks(const par_basic_mapped_file<charType>& file, size_t offset, size_t chunkSize, size_t lookahead) -> void {
+    file.advise(par_access_hint::will_need, offset, (lookahead + 1) * chunkSize);
+}
+
+// Positioned asynchronous reads and writes of a file: read() and write() return a future holding the number
+// of bytes transferred, which is smaller than requested only when a read reaches the end of the file. The
+// operations are submitted to an io_uring ring when the library is built with ABPARALLEL_USE_IO_URING and
+// liburing is available (a completion thread fulfils the futures), and otherwise run as blocking
+// pread/pwrite calls in their own task. Buffers must stay alive until their operation completes; the
+// destructor waits for all the pending operations
+
+class par_async_file {
+public:
+    enum class mode {
+        read_only,
+        read_write,
+        create
+    };
+
+    explicit par_async_file(const std::string& path, mode openMode = mode::read_only) : filePath(path), pending(0) {
+#if defined(_WIN32)
+        const auto access = openMode == mode::read_only ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+        fileHandle = CreateFileA(path.c_str(), access, FILE_SHARE_READ, nullptr,
+                                 openMode == mode::create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+            detail::par_throw_system_error("par_async_file: cannot open " + path);
+#else
+        auto flags = openMode == mode::read_only ? O_RDONLY : O_RDWR;
+        if (openMode == mode::create)
+            flags |= O_CREAT | O_TRUNC;
+        fileDescriptor = ::open(path.c_str(), flags, 0644);
+        if (fileDescriptor < 0)
+            detail::par_throw_system_error("par_async_file: cannot open " + path);
+#endif
+#if defined(ABPARALLEL_IO_URING)
+        ringStarted = io_uring_queue_init(64, &ring, 0) == 0;
+        ringActive = ringStarted;
+        if (ringStarted)
+            completionThread = std::thread([this] { complete(); });
+#endif
+    }
+
+    par_async_file(const par_async_file&) = delete;
+    auto operator=(const par_async_file&) -> par_async_file& = delete;
+
+    ~par_async_file() {
+        {
+            std::unique_lock<std::mutex> lock(pendingMutex);
+            pendingDone.wait(lock, [this] { return pending == 0; });
+        }
+#if defined(ABPARALLEL_IO_URING)
+        if (ringStarted) {
+            {
+                std::lock_guard<std::mutex> lock(submitMutex);
+                auto entry = io_uring_get_sqe(&ring);
+                while (entry == nullptr) {
+                    io_uring_submit(&ring);
+                    entry = io_uring_get_sqe(&ring);
+                }
+                io_uring_prep_nop(entry);
+                io_uring_sqe_set_data(entry, nullptr);
+                io_uring_submit(&ring);
+            }
+            completionThread.join();
+            io_uring_queue_exit(&ring);
+        }
+#endif
+#if defined(_WIN32)
+        CloseHandle(fileHandle);
+#else
+        ::close(fileDescriptor);
+#endif
+    }
+
+    auto size() const -> std::uint64_t {
+#if defined(_WIN32)
+        auto fileSize = LARGE_INTEGER{};
+        if (!GetFileSizeEx(fileHandle, &fileSize))
+            detail::par_throw_system_error("par_async_file: cannot read the size of " + filePath);
+        return static_cast<std::uint64_t>(fileSize.QuadPart);
+#else
+        struct stat status;
+        if (fstat(fileDescriptor, &status) != 0)
+            detail::par_throw_system_error("par_async_file: cannot read the size of " + filePath);
+        return static_cast<std::uint64_t>(status.st_size);
+#endif
+    }
+
+    auto read(void* data, size_t bytes, std::uint64_t offset) -> std::future<size_t> {
+        return start(static_cast<char*>(data), bytes, offset, false);
+    }
+
+    auto write(const void* data, size_t bytes, std::uint64_t offset) -> std::future<size_t> {
+        return start(static_cast<char*>(const_cast<void*>(data)), bytes, offset, true);
+    }
+
+    auto uses_io_uring() const -> bool {
+#if defined(ABPARALLEL_IO_URING)
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        return ringActive;
+#else
+        return false;
+#endif
+    }
+
+private:
+    struct request {
+        std::promise<size_t> promise;
+        char* data;
+        size_t bytes;
+        std::uint64_t offset;
+        size_t done;
+        bool write;
+    };
+
+    auto start(char* data, size_t bytes, std::uint64_t offset, bool write) -> std::future<size_t> {
+#if defined(ABPARALLEL_IO_URING)
+        {
+            // The operation is submitted under the lock taken by fail(), so it is either queued on a running
+            // ring and tracked in flight, or falls back to the blocking path once the ring has failed
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            ++pending;
+            if (ringActive) {
+                auto operation = new request{std::promise<size_t>(), data, bytes, offset, 0, write};
+                auto future = operation->promise.get_future();
+                inFlight.insert(operation);
+                submit(operation);
+                return future;
+            }
+        }
+#else
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            ++pending;
+        }
+#endif
+        return std::async(std::launch::async, [this, data, bytes, offset, write] () -> size_t {
+            try {
+                const auto done = transfer(data, bytes, offset, write);
+                finish();
+                return done;
+            }
+            catch (...) {
+                finish();
+                throw;
+            }
+        });
+    }
+
+    auto finish() -> void {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (--pending == 0)
+            pendingDone.notify_all();
+    }
+
+    // Blocking transfer, repeated until all the bytes are transferred or the end of the file is reached
+
+    auto transfer(char* data, size_t bytes, std::uint64_t offset, bool write) -> size_t {
+        auto done = size_t{0};
+        while (done < bytes) {
+#if defined(_WIN32)
+            auto overlapped = OVERLAPPED{};
+            overlapped.Offset = static_cast<DWORD>((offset + done) & 0xFFFFFFFF);
+            overlapped.OffsetHigh = static_cast<DWORD>((offset + done) >> 32);
+            const auto count = static_cast<DWORD>(std::min(bytes - done, size_t{1} << 30));
+            auto transferred = DWORD{0};
+            const auto succeeded = write ? WriteFile(fileHandle, data + done, count, &transferred, &overlapped)
+                                         : ReadFile(fileHandle, data + done, count, &transferred, &overlapped);
+            if (!succeeded && GetLastError() != ERROR_HANDLE_EOF)
+                detail::par_throw_system_error("par_async_file: cannot transfer the data of " + filePath);
+#else
+            const auto count = std::min(bytes - done, size_t{1} << 30);
+            const auto transferred = write ? ::pwrite(fileDescriptor, data + done, count, static_cast<off_t>(offset + done))
+                                           : ::pread(fileDescriptor, data + done, count, static_cast<off_t>(offset + done));
+            if (transferred < 0 && errno == EINTR)
+                continue;
+            if (transferred < 0)
+                detail::par_throw_system_error("par_async_file: cannot transfer the data of " + filePath);
+#endif
+            if (transferred == 0)
+                break;
+            done += static_cast<size_t>(transferred);
+        }
+        return done;
+    }
+
+#if defined(ABPARALLEL_IO_URING)
+    // Queue the remaining part of an operation on the ring. Lock order: pendingMutex, then submitMutex
+
+    auto submit(request* operation) -> void {
+        std::lock_guard<std::mutex> lock(submitMutex);
+        auto entry = io_uring_get_sqe(&ring);
+        while (entry == nullptr) {
+            io_uring_submit(&ring);
+            entry = io_uring_get_sqe(&ring);
+        }
+        const auto count = static_cast<unsigned>(std::min(operation->bytes - operation->done, size_t{1} << 30));
+        if (operation->write)
+            io_uring_prep_write(entry, fileDescriptor, operation->data + operation->done, count, operation->offset + operation->done);
+        else
+            io_uring_prep_read(entry, fileDescriptor, operation->data + operation->done, count, operation->offset + operation->done);
+        io_uring_sqe_set_data(entry, operation);
+        io_uring_submit(&ring);
+    }
+
+    // Completion thread: short transfers are resubmitted, the futures are fulfilled once an operation is
+    // complete, and the thread stops at the operation without request queued by the destructor. If the ring
+    // fails, every operation in flight fails with the error and the following ones use the blocking path
+
+    auto complete() -> void {
+        while (true) {
+            io_uring_cqe* completion = nullptr;
+            const auto waited = io_uring_wait_cqe(&ring, &completion);
+            if (waited == -EINTR)
+                continue;
+            if (waited < 0) {
+                fail(-waited);
+                return;
+            }
+            auto operation = static_cast<request*>(io_uring_cqe_get_data(completion));
+            const auto result = completion->res;
+            io_uring_cqe_seen(&ring, completion);
+            if (operation == nullptr)
+                return;
+            if (result == -EINTR || result == -EAGAIN) {
+                submit(operation);
+                continue;
+            }
+            if (result < 0) {
+                operation->promise.set_exception(std::make_exception_ptr(std::system_error(-result, std::generic_category(),
+                                                                                           "par_async_file: cannot transfer the data of " + filePath)));
+            }
+            else {
+                operation->done += static_cast<size_t>(result);
+                if (result > 0 && operation->done < operation->bytes) {
+                    submit(operation);
+                    continue;
+                }
+                operation->promise.set_value(operation->done);
+            }
+            {
+                std::lock_guard<std::mutex> lock(pendingMutex);
+                inFlight.erase(operation);
+            }
+            delete operation;
+            finish();
+        }
+    }
+
+    auto fail(int error) -> void {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        ringActive = false;
+        for (auto operation : inFlight) {
+            operation->promise.set_exception(std::make_exception_ptr(std::system_error(error, std::generic_category(),
+                                                                                       "par_async_file: io_uring failure on " + filePath)));
+            delete operation;
+            --pending;
+        }
+        inFlight.clear();
+        if (pending == 0)
+            pendingDone.notify_all();
+    }
+#endif
+
+    std::string filePath;
+#if defined(_WIN32)
+    HANDLE fileHandle;
+#else
+    int fileDescriptor;
+#endif
+    size_t pending;
+    mutable std::mutex pendingMutex;
+    std::condition_variable pendingDone;
+#if defined(ABPARALLEL_IO_URING)
+    bool ringStarted;
+    bool ringActive;
+    std::unordered_set<request*> inFlight;
+    io_uring ring;
+    std::mutex submitMutex;
+    std::thread completionThread;
+#endif
+};
+
+namespace detail {
+
+// Temporary files removed on destruction
+
+struct par_temporary_files {
+    ~par_temporary_files() {
+        for (const auto& path : paths)
+            std::remove(path.c_str());
+    }
+
+    std::vector<std::string> paths;
+};
+
+// Sorted run of an external sort, read block by block with the next block being read ahead asynchronously
+
+template <typename T>
+struct par_run_reader {
+    par_run_reader(par_async_file& file, size_t size, size_t blockSize)
+        : file(file), offset(0), remaining(size), blockSize(blockSize), position(0) {
+        readAhead();
+        refill();
+    }
+
+    ~par_run_reader() {
+        if (next.valid())
+            next.wait();
+    }
+
+    auto exhausted() const -> bool {
+        return position == block.size() && remaining == 0 && !next.valid();
+    }
+
+    // Swap in the block read ahead and start reading the following one
+
+    auto refill() -> void {
+        if (next.get() != nextBlock.size() * sizeof(T))
+            throw std::runtime_error("par_external_sort: unexpected end of a sorted run");
+        block.swap(nextBlock);
+        position = 0;
+        if (remaining > 0)
+            readAhead();
+    }
+
+    auto readAhead() -> void {
+        const auto count = std::min(blockSize, remaining);
+        nextBlock.resize(count);
+        next = file.read(nextBlock.data(), count * sizeof(T), offset);
+        offset += count * sizeof(T);
+        remaining -= count;
+    }
+
+    par_async_file& file;
+    std::uint64_t offset;
+    size_t remaining;
+    size_t blockSize;
+    size_t position;
+    std::vector<T> block;
+    std::vector<T> nextBlock;
+    std::future<size_t> next;
+};
+
+} // namespace detail
+
+// Parallel external sort of a binary file of trivially copyable elements that may not fit in memory. The
+// input is cut into runs that fit in the memory budget (in bytes), which are sorted with par_sort and
+// spilled to temporary files next to the output file while the next run is being read. The runs are then
+// merged in batches: every run keeps a block in memory with the next block read ahead, all the buffered
+// elements not greater than the smallest last buffered element of the unfinished runs are merged with
+// par_kway_merge, and each merged batch is written while the next one is being merged. All the reads and
+// writes go through par_async_file
+
+template <typename T, typename functor>
+auto par_external_sort(const std::string& inputPath, const std::string& outputPath, functor func, size_t memoryBudget, size_t chunkSize) -> void {
+    static_assert(std::is_trivially_copyable<T>::value, "par_external_sort requires trivially copyable elements");
+
+    // The buffers are declared before the files, whose destructors wait for the pending operations
+    auto buffers = std::array<std::vector<T>, 2>{};
+    auto temporaryFiles = detail::par_temporary_files{};
+    par_async_file input(inputPath);
+    const auto inputSize = input.size();
+    if (inputSize % sizeof(T) != 0)
+        throw std::runtime_error("par_external_sort: the size of " + inputPath + " is not a multiple of the element size");
+    const auto n = static_cast<size_t>(inputSize / sizeof(T));
+
+    // Sort the runs: one buffer is being read while the other one is sorted (par_sort needs a temporary
+    // buffer as large as the run) then written. A single run is written directly to the output file
+    const auto runSize = std::max(memoryBudget / (3 * sizeof(T)), size_t{1});
+    const auto runCount = std::max((n + runSize - 1) / runSize, size_t{1});
+    const auto readRun = [&] (size_t runId) -> std::future<size_t> {
+        auto& run = buffers[runId % 2];
+        run.resize(std::min(runSize, n - runId * runSize));
+        return input.read(run.data(), run.size() * sizeof(T), static_cast<std::uint64_t>(runId) * runSize * sizeof(T));
+    };
+    auto runFiles = std::vector<std::unique_ptr<par_async_file>>{};
+    auto readFuture = readRun(0);
+    auto writeFuture = std::future<size_t>{};
+    for (size_t runId = 0; runId < runCount; ++runId) {
+        auto& run = buffers[runId % 2];
+        if (readFuture.get() != run.size() * sizeof(T))
+            throw std::runtime_error("par_external_sort: unexpected end of " + inputPath);
+        if (writeFuture.valid())
+            writeFuture.get();
+        if (runId + 1 < runCount)
+            readFuture = readRun(runId + 1);
+        par_sort(run.begin(), run.end(), func, chunkSize);
+
+        const auto runPath = runCount == 1 ? outputPath : outputPath + ".run" + std::to_string(runId);
+        if (runCount > 1)
+            temporaryFiles.paths.push_back(runPath);
+        runFiles.emplace_back(new par_async_file(runPath, par_async_file::mode::create));
+        writeFuture = runFiles.back()->write(run.data(), run.size() * sizeof(T), 0);
+    }
+    writeFuture.get();
+    if (runCount == 1)
+        return;
+
+    // Every run holds two blocks (the current one and the one read ahead) and every merged batch can hold
+    // a block per run, the batch being merged while the previous one is written
+    const auto blockSize = std::max(memoryBudget / (4 * runCount * sizeof(T)), size_t{1});
+    auto batches = std::array<std::vector<T>, 2>{};
+    par_async_file output(outputPath, par_async_file::mode::create);
+    auto readers = std::vector<std::unique_ptr<detail::par_run_reader<T>>>{};
+    for (size_t runId = 0; runId < runCount; ++runId)
+        readers.emplace_back(new detail::par_run_reader<T>(*runFiles[runId], std::min(runSize, n - runId * runSize), blockSize));
+
+    auto outputOffset = std::uint64_t{0};
+    for (size_t batchId = 0; ; batchId = 1 - batchId) {
+        for (auto& reader : readers) {
+            if (reader->position == reader->block.size() && !reader->exhausted())
+                reader->refill();
+        }
+
+        // Only the elements not greater than the last buffered element of every unfinished run can be merged
+        const T* bound = nullptr;
+        for (const auto& reader : readers) {
+            if (reader->remaining > 0 || reader->next.valid()) {
+                if (bound == nullptr || func(reader->block.back(), *bound))
+                    bound = &reader->block.back();
+            }
+        }
+        auto segments = std::vector<std::pair<const T*, const T*>>{};
+        for (auto& reader : readers) {
+            const auto first = reader->block.data() + reader->position;
+            const auto last = reader->block.data() + reader->block.size();
+            const auto stop = bound == nullptr ? last : std::upper_bound(first, last, *bound, func);
+            if (stop != first)
+                segments.emplace_back(first, stop);
+            reader->position += static_cast<size_t>(stop - first);
+        }
+        if (segments.empty())
+            break;
+
+        auto& batch = batches[batchId];
+        if (writeFuture.valid())
+            writeFuture.get();
+        auto batchSize = size_t{0};
+        for (const auto& segment : segments)
+            batchSize += static_cast<size_t>(segment.second - segment.first);
+        batch.resize(batchSize);
+        par_kway_merge(segments, batch.begin(), func, chunkSize);
+        writeFuture = output.write(batch.data(), batch.size() * sizeof(T), outputOffset);
+        outputOffset += batch.size() * sizeof(T);
+    }
+    if (writeFuture.valid())
+        writeFuture.get();
+}
+
+template <typename T>
+auto par_external_sort(const std::string& inputPath, const std::string& outputPath, size_t memoryBudget, size_t chunkSize) -> void {
+    par_external_sort<T>(inputPath, outputPath, std::less<T>(), memoryBudget, chunkSize);
+}
+
+// Source and sink of a stream of trivially copyable elements stored in a binary file, read and written
+// sequentially from an offset
+
+template <typename T>
+struct par_file_source {
+    explicit par_file_source(par_async_file& file, std::uint64_t offset = 0) : file(&file), offset(offset) {}
+
+    auto operator()(T* data, size_t capacity) -> size_t {
+        const auto bytes = file->read(data, capacity * sizeof(T), offset).get();
+        offset += bytes;
+        return bytes / sizeof(T);
+    }
+
+    par_async_file* file;
+    std::uint64_t offset;
+};
+
+template <typename T>
+struct par_file_sink {
+    explicit par_file_sink(par_async_file& file, std::uint64_t offset = 0) : file(&file), offset(offset) {}
+
+    auto operator()(const std::vector<T>& block) -> void {
+        offset += file->write(block.data(), block.size() * sizeof(T), offset).get();
+    }
+
+    par_async_file* file;
+    std::uint64_t offset;
+};
+
+// Streaming executor with bounded memory: the source fills blocks of at most blockSize elements
+// (source(data, capacity) returns the number of elements written, 0 at the end of the stream), the stage
+// processes each block in place (it may shrink or grow it) and the sink consumes the processed blocks in
+// order. Three blocks rotate so that the next block is read and the previous one is consumed while the
+// stage runs; the source and the sink are never called concurrently with themselves. Returns the number of
+// elements read from the source
+
+template <typename T, typename sourceFunctor, typename stageFunctor, typename sinkFunctor>
+auto par_stream(sourceFunctor source, stageFunctor stage, sinkFunctor sink, size_t blockSize) -> size_t {
+    auto blocks = std::array<std::vector<T>, 3>{};
+    const auto read = [&source, blockSize] (std::vector<T>* block) {
+        block->resize(blockSize);
+        block->resize(source(block->data(), blockSize));
+    };
+
+    auto count = size_t{0};
+    auto readFuture = std::async(std::launch::async, read, &blocks[0]);
+    auto sinkFuture = std::future<void>{};
+    for (size_t blockId = 0; ; ++blockId) {
+        const auto block = &blocks[blockId % 3];
+        readFuture.get();
+        if (block->empty())
+            break;
+        count += block->size();
+
+        // The block read next was consumed by the sink before the previous block was handed over to it
+        readFuture = std::async(std::launch::async, read, &blocks[(blockId + 1) % 3]);
+        stage(*block);
+        if (sinkFuture.valid())
+            sinkFuture.get();
+        sinkFuture = std::async(std::launch::async, [&sink, block] {
+            sink(static_cast<const std::vector<T>&>(*block));
+        });
+    }
+    if (sinkFuture.valid())
+        sinkFuture.get();
+
+    return count;
+}
+
+// Streaming version of par_transform, the elements being transformed in place
+
+template <typename T, typename sourceFunctor, typename functor, typename sinkFunctor>
+auto par_stream_transform(sourceFunctor source, functor func, sinkFunctor sink, size_t blockSize, size_t chunkSize) -> size_t {
+    return par_stream<T>(source, [&func, chunkSize] (std::vector<T>& block) {
+        par_transform(block.begin(), block.end(), block.begin(), func, chunkSize);
+    }, sink, blockSize);
+}
+
+// Streaming version of par_copy_if, only the selected elements reaching the sink
+
+template <typename T, typename sourceFunctor, typename functor, typename sinkFunctor>
+auto par_stream_copy_if(sourceFunctor source, functor func, sinkFunctor sink, size_t blockSize, size_t chunkSize) -> size_t {
+    auto selected = std::vector<T>{};
+    return par_stream<T>(source, [&func, &selected, chunkSize] (std::vector<T>& block) {
+        selected.resize(block.size());
+        selected.erase(par_copy_if(block.begin(), block.end(), selected.begin(), func, chunkSize), selected.end());
+        block.swap(selected);
+    }, sink, blockSize);
+}
+
+// Streaming version of par_sum: the sum of the elements of the stream after applying a functor to each element
+
+template <typename T, typename sourceFunctor, typename functor>
+auto par_stream_sum(sourceFunctor source, functor func, size_t blockSize, size_t chunkSize) -> T {
+    auto sum = T(0);
+    par_stream<T>(source, [&func, &sum, chunkSize] (std::vector<T>& block) {
+        sum += par_sum(block.begin(), block.end(), func, chunkSize);
+    }, [] (const std::vector<T>&) {}, blockSize);
+    return sum;
+}
+
+
+// Codecs of the blocks written by par_compress
+
+enum class par_codec : std::uint8_t {
+    stored = 0,
+    lz = 1,
+    lz4 = 2,
+    zstd = 3
+};
+
+// Default codec: zstd when available, then LZ4, then the built-in LZ codec
+
+inline auto par_default_codec() -> par_codec {
+#if defined(ABPARALLEL_ZSTD)
+    return par_codec::zstd;
+#elif defined(ABPARALLEL_LZ4)
+    return par_codec::lz4;
+#else
+    return par_codec::lz;
+#endif
+}
+
+namespace detail {
+
+// Little-endian encoding of the integers of the compressed frames
+
+template <typename T>
+auto par_store_le(char* dst, T value) -> void {
+    for (size_t byteId = 0; byteId < sizeof(T); ++byteId)
+        dst[byteId] = static_cast<char>(static_cast<std::uint64_t>(value) >> (8 * byteId));
+}
+
+template <typename T>
+auto par_load_le(const char* src) -> T {
+    auto value = std::uint64_t{0};
+    for (size_t byteId = 0; byteId < sizeof(T); ++byteId)
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(src[byteId])) << (8 * byteId);
+    return static_cast<T>(value);
+}
+
+// Built-in LZ codec: a block is a sequence of tokens, each token holding a number of literals copied as is
+// followed by a match (length, 16-bit backward offset) copied from the output already produced. The token
+// byte keeps both lengths on 4 bits, longer lengths being continued with bytes of 255. Matches are found
+// greedily with a hash table of the positions of 4-byte sequences; the last token has no match
+
+inline auto par_lz_write_length(std::vector<char>& dst, size_t length) -> void {
+    for (; length >= 255; length -= 255)
+        dst.push_back(static_cast<char>(255));
+    dst.push_back(static_cast<char>(length));
+}
+
+inline auto par_lz_emit(std::vector<char>& dst, const char* literals, size_t literalCount, size_t offset, size_t matchLength) -> void {
+    const auto matchCode = matchLength == 0 ? size_t{0} : matchLength - 4;
+    dst.push_back(static_cast<char>((std::min(literalCount, size_t{15}) << 4) | std::min(matchCode, size_t{15})));
+    if (literalCount >= 15)
+        par_lz_write_length(dst, literalCount - 15);
+    dst.insert(dst.end(), literals, literals + literalCount);
+    if (matchLength == 0)
+        return;
+    dst.push_back(static_cast<char>(offset & 0xFF));
+    dst.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15)
+        par_lz_write_length(dst, matchCode - 15);
+}
+
+inline auto par_lz_compress(const char* src, size_t n) -> std::vector<char> {
+    auto dst = std::vector<char>{};
+    dst.reserve(n);
+    auto table = std::vector<std::uint32_t>(size_t{1} << 12, 0);
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + 4 <= n) {
+        std::uint32_t sequence;
+        std::memcpy(&sequence, src + i, 4);
+        const auto slot = (sequence * 2654435761u) >> 20;
+        const auto candidate = static_cast<size_t>(table[slot]);
+        table[slot] = static_cast<std::uint32_t>(i + 1);
+        if (candidate == 0 || i + 1 - candidate > 65535 || std::memcmp(src + candidate - 1, src + i, 4) != 0) {
+            ++i;
+            continue;
+        }
+        const auto matchStart = candidate - 1;
+        auto matchLength = size_t{4};
+        while (i + matchLength < n && src[matchStart + matchLength] == src[i + matchLength])
+            ++matchLength;
+        par_lz_emit(dst, src + anchor, i - anchor, i - matchStart, matchLength);
+        i += matchLength;
+        anchor = i;
+    }
+    par_lz_emit(dst, src + anchor, n - anchor, 0, 0);
+    return dst;
+}
+
+inline auto par_lz_decompress(const char* src, size_t size, char* dst, size_t n) -> void {
+    const auto srcEnd = src + size;
+    const auto readLength = [&] (size_t length) -> size_t {
+        for (unsigned char byte = 255; byte == 255; length += byte) {
+            if (src == srcEnd)
+                throw std::runtime_error("par_decompress: corrupted block");
+            byte = static_cast<unsigned char>(*src++);
+        }
+        return length;
+    };
+    auto out = size_t{0};
+    while (out < n) {
+        if (src == srcEnd)
+            throw std::runtime_error("par_decompress: corrupted block");
+        const auto token = static_cast<unsigned char>(*src++);
+        auto literalCount = static_cast<size_t>(token >> 4);
+        if (literalCount == 15)
+            literalCount = readLength(literalCount);
+        if (literalCount > static_cast<size_t>(srcEnd - src) || literalCount > n - out)
+            throw std::runtime_error("par_decompress: corrupted block");
+        std::memcpy(dst + out, src, literalCount);
+        src += literalCount;
+        out += literalCount;
+        if (out == n)
+            break;
+
+        if (srcEnd - src < 2)
+            throw std::runtime_error("par_decompress: corrupted block");
+        const auto offset = static_cast<size_t>(par_load_le<std::uint16_t>(src));
+        src += 2;
+        auto matchLength = static_cast<size_t>(token & 0x0F);
+        if (matchLength == 15)
+            matchLength = readLength(matchLength);
+        matchLength += 4;
+        if (offset == 0 || offset > out || matchLength > n - out)
+            throw std::runtime_error("par_decompress: corrupted block");
+
+        // The match may overlap the bytes it produces
+        for (size_t byteId = 0; byteId < matchLength; ++byteId, ++out)
+            dst[out] = dst[out - offset];
+    }
+}
+
+// Compress a block with the given codec, the block being stored as is when it does not shrink
+
+inline auto par_compress_block(const char* src, size_t n, par_codec codec) -> std::vector<char> {
+    auto compressed = std::vector<char>{};
+    switch (codec) {
+    case par_codec::lz:
+        compressed = par_lz_compress(src, n);
+        break;
+#if defined(ABPARALLEL_LZ4)
+    case par_codec::lz4: {
+        compressed.resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(n))));
+        const auto size = LZ4_compress_default(src, compressed.data(), static_cast<int>(n), static_cast<int>(compressed.size()));
+        compressed.resize(size > 0 ? static_cast<size_t>(size) : n);
+        break;
+    }
+#endif
+#if defined(ABPARALLEL_ZSTD)
+    case par_codec::zstd: {
+        compressed.resize(ZSTD_compressBound(n));
+        const auto size = ZSTD_compress(compressed.data(), compressed.size(), src, n, 1);
+        compressed.resize(ZSTD_isError(size) ? n : size);
+        break;
+    }
+#endif
+    case par_codec::stored:
+        break;
+    default:
+        throw std::invalid_argument("par_compress: codec not available in this build");
+    }
+    if (codec == par_codec::stored || compressed.size() >= n)
+        compressed.assign(src, src + n);
+    return compressed;
+}
+
+inline auto par_decompress_block(const char* src, size_t size, char* dst, size_t n, par_codec codec) -> void {
+    if (size == n) {
+        std::memcpy(dst, src, n);
+        return;
+    }
+    switch (codec) {
+    case par_codec::lz:
+        par_lz_decompress(src, size, dst, n);
+        return;
+#if defined(ABPARALLEL_LZ4)
+    case par_codec::lz4:
+        if (LZ4_decompress_safe(src, dst, static_cast<int>(size), static_cast<int>(n)) != static_cast<int>(n))
+            throw std::runtime_error("par_decompress: corrupted block");
+        return;
+#endif
+#if defined(ABPARALLEL_ZSTD)
+    case par_codec::zstd:
+        if (ZSTD_decompress(dst, n, src, size) != n)
+            throw std::runtime_error("par_decompress: corrupted block");
+        return;
+#endif
+    default:
+        throw std::runtime_error("par_decompress: codec not available in this build");
+    }
+}
+
+// Size of the header of a compressed frame: magic "ABPZ", version, codec, two reserved bytes, then the
+// uncompressed size, the block size and the number of blocks on 8 bytes each. The header is followed by
+// the block index (the compressed size of each block on 8 bytes, a block whose compressed size equals its
+// uncompressed size being stored as is) and by the blocks
+
+const size_t par_frame_header_size = 32;
+
+} // namespace detail
+
+// Parallel compression of a byte buffer: every chunk is compressed independently by its own task with the
+// given codec (the fastest available one by default), then the blocks are copied in parallel after the
+// block index. LZ4 and zstd are used when the library is built with ABPARALLEL_USE_LZ4 or ABPARALLEL_USE_ZSTD
+// and their headers are found
+
+template <typename srcIt>
+auto par_compress(srcIt first, srcIt last, par_codec codec, size_t chunkSize) -> std::vector<char> {
+    static_assert(detail::par_is_byte_range<srcIt>::value, "par_compress requires a contiguous range of bytes");
+    const auto n = static_cast<size_t>(std::distance(first, last));
+    const auto src = n > 0 ? reinterpret_cast<const char*>(&*first) : nullptr;
+#if defined(ABPARALLEL_LZ4)
+    if (codec == par_codec::lz4 && chunkSize > static_cast<size_t>(LZ4_MAX_INPUT_SIZE))
+        throw std::invalid_argument("par_compress: chunk size too large for LZ4");
+#endif
+
+    // Create a table of futures to compress each block asynchronously
+    auto futures = std::vector<std::future<std::vector<char>>>{};
+    futures.reserve(n / chunkSize + 1);
+    for (size_t startId = 0; startId < n; startId += chunkSize) {
+        const auto stopId = std::min(startId + chunkSize, n);
+        auto future = std::async(std::launch::async, [=] {
+            return detail::par_compress_block(src + startId, stopId - startId, codec);
+        });
+        futures.emplace_back(std::move(future));
+    }
+    auto blocks = std::vector<std::vector<char>>{};
+    blocks.reserve(futures.size());
+    auto blockOffsets = std::vector<size_t>{detail::par_frame_header_size + 8 * futures.size()};
+    for (auto& future : futures) {
+        blocks.push_back(future.get());
+        blockOffsets.push_back(blockOffsets.back() + blocks.back().size());
+    }
+
+    // Write the header and the block index, then copy the blocks
+    auto frame = std::vector<char>(blockOffsets.back());
+    std::memcpy(frame.data(), "ABPZ", 4);
+    frame[4] = 1;
+    frame[5] = static_cast<char>(codec);
+    detail::par_store_le(frame.data() + 8, static_cast<std::uint64_t>(n));
+    detail::par_store_le(frame.data() + 16, static_cast<std::uint64_t>(chunkSize));
+    detail::par_store_le(frame.data() + 24, static_cast<std::uint64_t>(blocks.size()));
+    for (size_t blockId = 0; blockId < blocks.size(); ++blockId)
+        detail::par_store_le(frame.data() + detail::par_frame_header_size + 8 * blockId, static_cast<std::uint64_t>(blocks[blockId].size()));
+    auto copyFutures = std::vector<std::future<void>>{};
+    copyFutures.reserve(blocks.size());
+    for (size_t blockId = 0; blockId < blocks.size(); ++blockId) {
+        auto future = std::async(std::launch::async, [=, &blocks, &frame] {
+            std::copy(blocks[blockId].begin(), blocks[blockId].end(), frame.begin() + blockOffsets[blockId]);
+        });
+        copyFutures.emplace_back(std::move(future));
+    }
+    for (auto& future : copyFutures)
+        future.wait();
+
+    return frame;
+}
+
+template <typename srcIt>
+auto par_compress(srcIt first, srcIt last, size_t chunkSize) -> std::vector<char> {
+    return par_compress(first, last, par_default_codec(), chunkSize);
+}
+
+// Parallel decompression of a frame written by par_compress, every block being decompressed by its own task
+
+template <typename srcIt>
+auto par_decompress(srcIt first, srcIt last) -> std::vector<char> {
+    static_assert(detail::par_is_byte_range<srcIt>::value, "par_decompress requires a contiguous range of bytes");
+    const auto size = static_cast<size_t>(std::distance(first, last));
+    const auto src = size > 0 ? reinterpret_cast<const char*>(&*first) : nullptr;
+    if (size < detail::par_frame_header_size || std::memcmp(src, "ABPZ", 4) != 0 || src[4] != 1)
+        throw std::runtime_error("par_decompress: not a compressed frame");
+    const auto codec = static_cast<par_codec>(src[5]);
+    const auto n = detail::par_load_le<std::uint64_t>(src + 8);
+    const auto blockSize = detail::par_load_le<std::uint64_t>(src + 16);
+    const auto blockCount = detail::par_load_le<std::uint64_t>(src + 24);
+    if (blockSize == 0 || blockCount > (size - detail::par_frame_header_size) / 8 || blockCount != n / blockSize + (n % blockSize != 0 ? 1 : 0))
+        throw std::runtime_error("par_decompress: corrupted frame header");
+    if (n > static_cast<std::uint64_t>(std::vector<char>().max_size()))
+        throw std::runtime_error("par_decompress: uncompressed size too large");
+    const auto blockLength = static_cast<size_t>(std::min(blockSize, n));
+
+    // Locate the blocks from the block index
+    auto blockOffsets = std::vector<size_t>{detail::par_frame_header_size + 8 * static_cast<size_t>(blockCount)};
+    for (size_t blockId = 0; blockId < blockCount; ++blockId) {
+        const auto blockSizeCompressed = detail::par_load_le<std::uint64_t>(src + detail::par_frame_header_size + 8 * blockId);
+        if (blockSizeCompressed > size - blockOffsets.back())
+            throw std::runtime_error("par_decompress: corrupted block index");
+        blockOffsets.push_back(blockOffsets.back() + static_cast<size_t>(blockSizeCompressed));
+    }
+
+    // Create a table of futures to decompress each block asynchronously
+    auto data = std::vector<char>(static_cast<size_t>(n));
+    auto futures = std::vector<std::future<void>>{};
+    futures.reserve(static_cast<size_t>(blockCount));
+    for (size_t blockId = 0; blockId < blockCount; ++blockId) {
+        const auto startId = blockId * blockLength;
+        const auto stopId = std::min(startId + blockLength, data.size());
+        auto future = std::async(std::launch::async, [=, &data] {
+            detail::par_decompress_block(src + blockOffsets[blockId], blockOffsets[blockId + 1] - blockOffsets[blockId],
+                                         data.data() + startId, stopId - startId, codec);
+        });
+        futures.emplace_back(std::move(future));
+    }
+    for (auto& future : futures)
+        future.get();
+
+    return data;
+}
+
+}
+
+#endif // ABPARALLEL_IO_H
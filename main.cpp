@@ -2,6 +2,7 @@
 #include <vector>
 #include <chrono>
 #include <cassert>
+#include <string>
 
 #include "include\parallel.h"
 
@@ -78,6 +79,31 @@ auto vector_par_sort(std::vector<int>& src, std::size_t chunkSize) -> void{
     ABParallel::par_sort(src.begin(), src.end() , chunkSize);
 }
 
+//Testing par_sort with a comparator taking its arguments by value (the elements must not be moved out)
+
+auto vector_par_sort_by_value(std::vector<int>& src, std::size_t chunkSize) -> void{
+    PRINT_FUNC();
+    std::vector<std::string> words(src.size() / 10);
+    std::transform(src.begin(), src.begin() + words.size(), words.begin(), [](int a){ return std::to_string(a); });
+    ABParallel::par_sort(words.begin(), words.end(), [](std::string a, std::string b){ return a < b; }, chunkSize);
+    assert(std::is_sorted(words.begin(), words.end()));
+    assert(std::none_of(words.begin(), words.end(), [](const std::string& a){ return a.empty(); }));
+}
+
+//Testing par_nth_element
+
+auto vector_par_nth_element(std::vector<int>& src, std::size_t chunkSize) -> void{
+    PRINT_FUNC();
+    ABParallel::par_nth_element(src.begin(), src.begin() + src.size() / 2, src.end(), chunkSize);
+}
+
+//Testing par_partial_sort
+
+auto vector_par_partial_sort(std::vector<int>& src, std::size_t chunkSize) -> void{
+    PRINT_FUNC();
+    ABParallel::par_partial_sort(src.begin(), src.begin() + 1000, src.end(), chunkSize);
+}
+
 //Testing generate
 auto vector_par_generate(std::vector<int>& src, std::size_t chunkSize) -> void{
     PRINT_FUNC();
@@ -97,6 +123,13 @@ auto vector_par_count(std::vector<int>& src, std::size_t chunkSize) -> void{
     ABParallel::par_count(src.begin(), src.end(), 250, chunkSize);
 }
 
+//Testing histogram
+auto vector_par_histogram(std::vector<int>& src, std::size_t chunkSize) -> void{
+    PRINT_FUNC();
+    std::vector<size_t> histogram(256);
+    ABParallel::par_histogram(src.begin(), src.end(), 0, 500000, histogram.size(), histogram.begin(), chunkSize);
+}
+
 //Testing find_if
 auto vector_par_find_if(std::vector<int>& src, std::size_t chunkSize) -> void{
     PRINT_FUNC();
@@ -118,6 +151,13 @@ auto vector_par_remove_if(std::vector<int>& src, std::size_t chunkSize) -> void{
     src.erase(foundIt, src.end());
 }
 
+//Testing par_partition
+
+auto vector_par_partition(std::vector<int>& src, std::size_t chunkSize) -> void{
+    PRINT_FUNC();
+    ABParallel::par_partition(src.begin(), src.end(), [](int a){ return a % 2 == 0; }, chunkSize);
+}
+
 //Testing none_of
 auto vector_par_none_of(std::vector<int>& src, std::size_t chunkSize) -> void{
     PRINT_FUNC();
@@ -136,6 +176,13 @@ auto vector_par_min_element(std::vector<int>& src, std::size_t chunkSize) -> voi
     ABParallel::par_min_element(src.begin(), src.end(), chunkSize);
 }
 
+//Testing top_k
+auto vector_par_top_k(std::vector<int>& src, std::size_t chunkSize) -> void{
+    PRINT_FUNC();
+    std::vector<int> best(1000);
+    ABParallel::par_top_k(src.begin(), src.end(), best.size(), best.begin(), chunkSize);
+}
+
 auto main() -> int{
 
     std::cout<<"Starting performance testing of few ABParallel algorithms. \n\nNote that the last chunk size corresponds to the sequential STL algorithm.\n\n";
@@ -148,15 +195,21 @@ auto main() -> int{
         vector_par_transform,
         vector_par_for_each,
         vector_par_sort,
+        vector_par_sort_by_value,
+        vector_par_nth_element,
+        vector_par_partial_sort,
         vector_par_generate,
         vector_par_sum,
         vector_par_count,
+        vector_par_histogram,
         vector_par_find_if,
         vector_par_replace_if,
         vector_par_remove_if,
+        vector_par_partition,
         vector_par_none_of,
         vector_par_max_element,
-        vector_par_min_element
+        vector_par_min_element,
+        vector_par_top_k
     };
 
     for(auto testedAlgorithm: testedAlgorithms){